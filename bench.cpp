@@ -0,0 +1,396 @@
+/*
+Performance suite for the gf2 operations.
+
+Every benchmark is named operation/input/degree, e.g. mul/dense/4096, and times one call per iteration.
+Iterations are added until a benchmark has run for --benchmark_min_time seconds, as Google Benchmark does,
+and the report uses its JSON layout, so its tools/compare.py can diff two runs for regressions.
+All inputs come from a fixed seed, so two runs with the same --seed time the same polynomials.
+
+options:
+  --benchmark_filter=<regex>     only the benchmarks whose name matches
+  --benchmark_min_time=<s>       minimum time per benchmark in seconds, default 0.5, 0 runs every benchmark once
+  --benchmark_format=console|json  format on stdout, default console
+  --benchmark_out=<file>         also writes the JSON report to file
+  --max_degree=<n>               skips the degrees above n
+  --seed=<s>                     seed of the inputs, default 42
+  --list                         prints the benchmark names only
+*/
+
+#include "gf2_polynomial.h"
+#include "gf2_search.h"
+#include "gf2_lfsr.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct gf2_bench_options {
+  std::string filter = ".";
+  double min_time = 0.5;
+  bool json = false;
+  std::string out;
+  uint64_t max_degree = std::numeric_limits<uint64_t>::max();
+  uint64_t seed = 42;
+  bool list = false;
+};
+
+// a benchmark builds its inputs from (degree, rng) and returns the timed call
+typedef std::function<std::function<void()>(uint64_t, std::mt19937_64&)> gf2_bench_setup;
+
+struct gf2_bench {
+  std::string name;
+  uint64_t degree;
+  gf2_bench_setup setup;
+};
+
+struct gf2_bench_result {
+  std::string name;
+  uint64_t degree;
+  uint64_t iterations;
+  double real_ns;
+  double cpu_ns;
+};
+
+// results are summed in here, so the optimizer cannot drop the timed calls
+volatile uint64_t gf2_bench_sink = 0;
+
+void consume(const gf2_polynomial& p) {
+  gf2_bench_sink = gf2_bench_sink + p.deg + p.words.size();
+}
+
+const uint64_t gf2_bench_degrees[] = {64, 256, 1024, 4096, 16384, 65536, 262144, 1000000};
+
+// x^n plus a random polynomial of degree below n
+gf2_polynomial make_monic(uint64_t n, std::mt19937_64& rng) {
+  return make_xn(n) + make_random_gf2_polynomial(n-1, rng);
+}
+
+// x^n + x^k + 1 or x^n + x^a + x^b + x^c + 1 with all middle exponents at most n/2, so the division folds
+gf2_polynomial make_sparse(uint64_t n, std::mt19937_64& rng, bool pentanomial) {
+  std::uniform_int_distribution<uint64_t> exponent(1, n/2);
+  gf2_polynomial f = make_xn(n) + make_xn(0);
+  if (!pentanomial)
+    return f + make_xn(exponent(rng));
+  uint64_t a, b, c;
+  do {
+    a = exponent(rng);
+    b = exponent(rng);
+    c = exponent(rng);
+  } while (a == b || b == c || a == c);
+  return f + make_xn(a) + make_xn(b) + make_xn(c);
+}
+
+/*
+The pair (a, b) of degrees (n, n-1) whose Euclidean remainder sequence has n steps with quotient x each,
+the longest there is: r_0 = 1, r_1 = x, r_(k+1) = x*r_k + r_(k-1).
+*/
+void make_fibonacci_pair(uint64_t n, gf2_polynomial& a, gf2_polynomial& b) {
+  b = make_xn(0);
+  a = make_xn(1);
+  for (uint64_t k = 1; k < n; ++k) {
+    gf2_polynomial next = mul_xn(a, 1);
+    next += b;
+    b = std::move(a);
+    a = std::move(next);
+  }
+}
+
+// r distinct irreducible polynomials of degree d drawn from rng
+std::vector<gf2_polynomial> make_irreducibles(uint64_t d, size_t r, std::mt19937_64& rng) {
+  gf2_search_options o;
+  o.degree = d;
+  o.form = gf2_search_random;
+  o.seed = rng();
+  o.chunk_size = 16;
+  gf2_thread_pool pool(1);
+  uint64_t next = 0;
+  std::vector<gf2_polynomial> found;
+  while (found.size() < r) {
+    for (auto& f : search_polynomials(o, r - found.size(), next, pool)) {
+      if (std::find(found.begin(), found.end(), f) == found.end())
+        found.push_back(std::move(f));
+    }
+  }
+  return found;
+}
+
+void add(std::vector<gf2_bench>& benches, const std::string& name, uint64_t max_degree, const gf2_bench_setup& setup) {
+  for (uint64_t n : gf2_bench_degrees) {
+    if (n <= max_degree)
+      benches.push_back(gf2_bench{name + "/" + std::to_string(n), n, setup});
+  }
+}
+
+/*
+The degree limits keep a full run within minutes: products, divisions and gcds are quasi linear and go up to 10^6,
+distinct degree and full factorization are quadratic and stop at 16384.
+*/
+std::vector<gf2_bench> make_gf2_benchmarks() {
+  std::vector<gf2_bench> b;
+  const uint64_t all = 1000000;
+
+  add(b, "mul/dense", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto x = make_random_gf2_polynomial(n, rng), y = make_random_gf2_polynomial(n, rng);
+    return [=] { consume(x*y); };
+  });
+  add(b, "mul/sparse", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto x = make_sparse(n, rng, false), y = make_random_gf2_polynomial(n, rng);
+    return [=] { consume(x*y); };
+  });
+  // a long operand times a single word one, the worst shape for the balanced algorithms
+  add(b, "mul/unbalanced", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto x = make_random_gf2_polynomial(n, rng), y = make_random_gf2_polynomial(63, rng);
+    return [=] { consume(x*y); };
+  });
+
+  // remainders of degree 2n by degree n
+  add(b, "mod/dense", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto x = make_random_gf2_polynomial(2*n, rng), f = make_monic(n, rng);
+    return [=] { consume(x % f); };
+  });
+  add(b, "mod/sparse", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto x = make_random_gf2_polynomial(2*n, rng), f = make_sparse(n, rng, true);
+    return [=] { consume(x % f); };
+  });
+  // x^2n mod x^n + x^(n-1) + 1: the middle term is too high to fold and every quotient bit is set
+  add(b, "mod/top_heavy", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto x = make_xn(2*n), f = make_xn(n) + make_xn(n-1) + make_xn(0);
+    (void)rng;
+    return [=] { consume(x % f); };
+  });
+  add(b, "hex_to_gf2_polynomial/dense", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    const std::string h = gf2_polynomial_to_hex(make_random_gf2_polynomial(n, rng));
+    return [=] { consume(hex_to_gf2_polynomial(h)); };
+  });
+  add(b, "mulmod/dense", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto m = std::make_shared<gf2_modulus>(make_gf2_modulus(make_monic(n, rng)));
+    auto x = make_random_gf2_polynomial(n-1, rng), y = make_random_gf2_polynomial(n-1, rng);
+    return [=] { consume(mulmod(x, y, *m)); };
+  });
+
+  add(b, "gcd/dense", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto x = make_monic(n, rng), y = make_monic(n-1, rng);
+    return [=] { consume(gcd(x, y)); };
+  });
+  // every quotient of the remainder sequence is x, the worst case of the Euclidean algorithm
+  add(b, "gcd/fibonacci", 65536, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    gf2_polynomial x, y;
+    make_fibonacci_pair(n, x, y);
+    (void)rng;
+    return [=] { consume(gcd(x, y)); };
+  });
+
+  add(b, "square_free_factorization/dense", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto f = make_monic(n, rng);
+    return [=] { consume(square_free_factorization(f)[0]); };
+  });
+  // a * b^2 * c^4 * d^8 with deg(a) = ... = deg(d) = n/15: every multiplicity needs the square root recursion
+  add(b, "square_free_factorization/powers", all, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    gf2_polynomial f = make_xn(0);
+    gf2_polynomial p;
+    for (uint64_t e = 1; e <= 8; e *= 2) {
+      p = make_monic(std::max<uint64_t>(1, n/15), rng);
+      for (uint64_t j = 0; j < e; ++j)
+        f *= p;
+    }
+    return [=] { consume(square_free_factorization(f)[0]); };
+  });
+
+  add(b, "distinct_degree_factorization/dense", 16384, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto f = make_monic(n, rng);
+    return [=] { consume(distinct_degree_factorization(f)[0].first); };
+  });
+  add(b, "distinct_degree_factorization/sparse", 16384, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto f = make_sparse(n, rng, true);
+    return [=] { consume(distinct_degree_factorization(f)[0].first); };
+  });
+  // an irreducible f has to be walked up to degree n/2
+  add(b, "distinct_degree_factorization/irreducible", 4096, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto f = make_irreducibles(n, 1, rng)[0];
+    return [=] { consume(distinct_degree_factorization(f)[0].first); };
+  });
+
+  // products of distinct irreducibles of degree d = min(max(16, n/16), 256)
+  add(b, "equal_degree_factorization/dense", 16384, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    const uint64_t d = std::min<uint64_t>(std::max<uint64_t>(16, n/16), 256);
+    gf2_polynomial f = make_xn(0);
+    for (const auto& g : make_irreducibles(d, n/d, rng))
+      f *= g;
+    return [=] { consume(equal_degree_factorization(f, d)[0]); };
+  });
+
+  add(b, "factor/dense", 16384, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto f = make_monic(n, rng);
+    return [=] { consume(factor(f)[0].first); };
+  });
+  add(b, "factor/sparse", 16384, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto f = make_sparse(n, rng, false);
+    return [=] { consume(factor(f)[0].first); };
+  });
+  // x^(n-1) + 1 splits into many factors of the same degree, the cyclotomic polynomials
+  add(b, "factor/cyclotomic", 16384, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    auto f = make_xn(n-1) + make_xn(0);
+    (void)rng;
+    return [=] { consume(factor(f)[0].first); };
+  });
+  // 2n random bits have linear complexity about n, the quadratic worst case
+  add(b, "berlekamp_massey/random", 65536, [](uint64_t n, std::mt19937_64& rng) -> std::function<void()> {
+    std::vector<uint64_t> w((2*n+63)/64);
+    for (auto& x : w)
+      x = rng();
+    return [=] { consume(berlekamp_massey(w, 2*n)); };
+  });
+  return b;
+}
+
+// runs the call with more and more iterations until min_time is reached, as Google Benchmark does
+gf2_bench_result run(const gf2_bench& bench, const gf2_bench_options& o) {
+  std::mt19937_64 rng(o.seed);
+  std::function<void()> f = bench.setup(bench.degree, rng);
+  gf2_random_engine().seed(o.seed);
+  // one untimed call warms up the caches and the lazily built tables
+  f();
+  uint64_t iterations = 1;
+  while (true) {
+    const std::clock_t cpu0 = std::clock();
+    const auto real0 = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; ++i)
+      f();
+    const double real = std::chrono::duration<double>(std::chrono::steady_clock::now() - real0).count();
+    const double cpu = (double)(std::clock() - cpu0) / CLOCKS_PER_SEC;
+    if (real >= o.min_time || iterations >= ((uint64_t)1 << 30)) {
+      return gf2_bench_result{bench.name, bench.degree, iterations, 1e9*real/(double)iterations, 1e9*cpu/(double)iterations};
+    }
+    // aim 40% past min_time, growing by at most 10x per round
+    const double factor = real > 0 ? 1.4*o.min_time/real : 10.0;
+    iterations = std::max(iterations+1, (uint64_t)((double)iterations*std::min(10.0, factor)));
+  }
+}
+
+std::string json_escape(const std::string& s) {
+  std::string r;
+  for (char c : s) {
+    if (c == '"' || c == '\\')
+      r.push_back('\\');
+    r.push_back(c);
+  }
+  return r;
+}
+
+std::string to_json(const std::vector<gf2_bench_result>& results, const gf2_bench_options& o, const char* executable) {
+  static const char* kernels[] = {"portable", "pclmul", "vpclmul"};
+  char date[64];
+  const std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+  std::ostringstream s;
+  s << "{\n  \"context\": {\n";
+  s << "    \"date\": \"" << date << "\",\n";
+  s << "    \"executable\": \"" << json_escape(executable) << "\",\n";
+  s << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n";
+#ifdef NDEBUG
+  s << "    \"library_build_type\": \"release\",\n";
+#else
+  s << "    \"library_build_type\": \"debug\",\n";
+#endif
+  s << "    \"gf2_mul_kernel\": \"" << kernels[gf2_active_mul_kernel()] << "\",\n";
+  s << "    \"seed\": " << o.seed << ",\n";
+  s << "    \"min_time\": " << o.min_time << "\n";
+  s << "  },\n  \"benchmarks\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    s << (i ? ",\n" : "\n");
+    s << "    {\n";
+    s << "      \"name\": \"" << json_escape(r.name) << "\",\n";
+    s << "      \"run_name\": \"" << json_escape(r.name) << "\",\n";
+    s << "      \"run_type\": \"iteration\",\n";
+    s << "      \"degree\": " << r.degree << ",\n";
+    s << "      \"iterations\": " << r.iterations << ",\n";
+    s << "      \"real_time\": " << r.real_ns << ",\n";
+    s << "      \"cpu_time\": " << r.cpu_ns << ",\n";
+    s << "      \"time_unit\": \"ns\"\n";
+    s << "    }";
+  }
+  s << "\n  ]\n}\n";
+  return s.str();
+}
+
+bool parse_option(const char* arg, const char* name, std::string& value) {
+  const size_t len = std::strlen(name);
+  if (std::strncmp(arg, name, len) != 0 || arg[len] != '=')
+    return false;
+  value = arg + len + 1;
+  return true;
+}
+
+} // namespace
+
+int main(int argc, const char* argv[])
+  {
+  gf2_bench_options o;
+  for (int i = 1; i < argc; ++i) {
+    std::string v;
+    if (parse_option(argv[i], "--benchmark_filter", v))
+      o.filter = v;
+    else if (parse_option(argv[i], "--benchmark_min_time", v))
+      o.min_time = std::stod(v);
+    else if (parse_option(argv[i], "--benchmark_format", v) && (v == "json" || v == "console"))
+      o.json = v == "json";
+    else if (parse_option(argv[i], "--benchmark_out", v))
+      o.out = v;
+    else if (parse_option(argv[i], "--max_degree", v))
+      o.max_degree = std::stoull(v);
+    else if (parse_option(argv[i], "--seed", v))
+      o.seed = std::stoull(v);
+    else if (std::strcmp(argv[i], "--list") == 0)
+      o.list = true;
+    else {
+      std::cerr << "unknown option " << argv[i] << "\n";
+      return 1;
+    }
+  }
+  const std::regex filter(o.filter);
+  std::vector<gf2_bench_result> results;
+  if (!o.json && !o.list)
+    std::printf("%-50s %16s %16s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+  for (const auto& bench : make_gf2_benchmarks()) {
+    if (bench.degree > o.max_degree || !std::regex_search(bench.name, filter))
+      continue;
+    if (o.list) {
+      std::printf("%s\n", bench.name.c_str());
+      continue;
+    }
+    results.push_back(run(bench, o));
+    const auto& r = results.back();
+    if (!o.json) {
+      std::printf("%-50s %16.0f %16.0f %12llu\n", r.name.c_str(), r.real_ns, r.cpu_ns, (unsigned long long)r.iterations);
+      std::fflush(stdout);
+    }
+  }
+  if (o.list)
+    return 0;
+  const std::string json = to_json(results, o, argv[0]);
+  if (o.json)
+    std::cout << json;
+  if (!o.out.empty()) {
+    std::ofstream f(o.out);
+    f << json;
+    if (!f) {
+      std::cerr << "cannot write " << o.out << "\n";
+      return 1;
+    }
+  }
+  return 0;
+  }
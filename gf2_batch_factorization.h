@@ -0,0 +1,85 @@
+#ifndef GF2_BATCH_FACTORIZATION_H
+#define GF2_BATCH_FACTORIZATION_H
+
+#include "gf2_polynomial.h"
+#include "gf2_thread_pool.h"
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+Factorization of many independent polynomials on a gf2_thread_pool.
+Results come back in input order. Worker w seeds its own random engine with seed + w before its first polynomial,
+so the randomized splitting never shares state between threads (the factors themselves do not depend on the seed).
+*/
+
+inline std::vector<gf2_factorization> factor_batch(const std::vector<gf2_polynomial>& polynomials, gf2_thread_pool& pool, uint64_t seed = 0, gf2_factor_method method = gf2_factor_automatic) {
+  std::vector<gf2_factorization> result(polynomials.size());
+  std::vector<char> seeded(pool.size(), 0);
+  pool.parallel_for(polynomials.size(), [&](size_t i, unsigned worker) {
+    if (!seeded[worker]) {
+      gf2_random_engine().seed(seed + worker);
+      seeded[worker] = 1;
+    }
+    result[i] = factor(polynomials[i], method);
+  });
+  return result;
+}
+
+// threads = 0 uses all hardware threads
+inline std::vector<gf2_factorization> factor_batch(const std::vector<gf2_polynomial>& polynomials, unsigned threads = 0, uint64_t seed = 0, gf2_factor_method method = gf2_factor_automatic) {
+  gf2_thread_pool pool(threads);
+  return factor_batch(polynomials, pool, seed, method);
+}
+
+// factors as hexadecimal numbers separated by spaces, with ^e for multiplicities above 1
+inline std::string factorization_to_hex(const gf2_factorization& factors) {
+  std::string s;
+  for (const auto& f : factors) {
+    if (!s.empty())
+      s.push_back(' ');
+    s += gf2_polynomial_to_hex(f.first);
+    if (f.second > 1)
+      s += "^" + std::to_string(f.second);
+  }
+  return s;
+}
+
+/*
+Reads one hexadecimal polynomial per line from in and writes "<polynomial>: <factors>" lines in the same order to out.
+Lines are factored in chunks of chunk_size so the input does not have to fit in memory, empty lines are skipped.
+Returns the number of polynomials factored.
+*/
+inline size_t factor_stream(std::istream& in, std::ostream& out, gf2_thread_pool& pool, size_t chunk_size = 4096, uint64_t seed = 0, gf2_factor_method method = gf2_factor_automatic) {
+  if (chunk_size == 0)
+    chunk_size = 1;
+  size_t total = 0;
+  uint64_t chunk = 0;
+  std::vector<std::string> lines;
+  std::vector<gf2_polynomial> polynomials;
+  std::string line;
+  bool more = true;
+  while (more) {
+    lines.clear();
+    polynomials.clear();
+    while (lines.size() < chunk_size && (more = (bool)std::getline(in, line))) {
+      while (!line.empty() && (line.back() == '\r' || line.back() == ' ' || line.back() == '\t'))
+        line.pop_back();
+      if (line.empty())
+        continue;
+      polynomials.push_back(hex_to_gf2_polynomial(line));
+      lines.push_back(line);
+    }
+    // chunk c seeds its workers with seed + c*pool.size() + w, disjoint from the seeds of every other chunk
+    auto factors = factor_batch(polynomials, pool, seed + chunk*pool.size(), method);
+    ++chunk;
+    for (size_t i = 0; i < lines.size(); ++i)
+      out << lines[i] << ": " << factorization_to_hex(factors[i]) << "\n";
+    total += lines.size();
+  }
+  return total;
+}
+
+#endif
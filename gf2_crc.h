@@ -0,0 +1,328 @@
+#ifndef GF2_CRC_H
+#define GF2_CRC_H
+
+#include "gf2_polynomial.h"
+
+#include <stdexcept>
+#include <vector>
+
+/*
+Cyclic redundancy checks for any generator g of degree w <= 64, in the parameter model of the CRC catalogues
+(init, reflect_in, reflect_out, xor_out). The checksum of a message m is m*x^w mod g with the register preset to init.
+
+The register is kept in the orientation of the input: bit reversed in the low w bits when the input is reflected,
+in the top w bits of a word otherwise, so both orientations shift whole bytes out with one table lookup.
+Slicing by 8 and by 16 look up 8 or 16 bytes at a time in tables of the checksums of a byte followed by zero bytes.
+With pclmulqdq four 128 bit lanes are folded forward by 512 bits with two carry-less products each, using
+constants x^k mod g computed with the polynomial arithmetic of this library, and the last 128 bits go through the tables.
+*/
+struct gf2_crc {
+  gf2_polynomial generator;
+  uint64_t width = 0;
+  uint64_t init = 0;
+  bool reflect_in = false;
+  bool reflect_out = false;
+  uint64_t xor_out = 0;
+  gf2_modulus modulus;
+  // table k holds the register change of a byte followed by k zero bytes, for k < 16
+  std::vector<uint64_t> tables;
+  // folding constants for the distances 128, 256, 384 and 512 bits, see gf2_crc_fold_pclmul
+  uint64_t fold[4][2] = {};
+};
+
+enum gf2_crc_method {
+  gf2_crc_automatic,
+  gf2_crc_bytewise,
+  gf2_crc_slicing_by_8,
+  gf2_crc_slicing_by_16,
+  gf2_crc_clmul
+};
+
+inline uint64_t gf2_crc_mask(uint64_t width) {
+  return width == 64 ? ~(uint64_t)0 : ((uint64_t)1 << width) - 1;
+}
+
+// the low w bits of x in reverse order
+inline uint64_t gf2_crc_reflect(uint64_t x, uint64_t width) {
+  return gf2_bit_reverse64(x) >> (64 - width);
+}
+
+// x^k mod g as a word, g of degree at most 64
+inline uint64_t gf2_crc_xn_mod(uint64_t k, const gf2_crc& c) {
+  gf2_polynomial r = make_xn(k);
+  reduce(r, c.modulus);
+  return is_zero(r) ? 0 : r.words[0];
+}
+
+inline gf2_crc make_gf2_crc(const gf2_polynomial& generator, uint64_t init, bool reflect_in, bool reflect_out, uint64_t xor_out) {
+  if (is_zero(generator) || degree(generator) == 0 || degree(generator) > 64)
+    throw std::runtime_error("make_gf2_crc: generator degree must be between 1 and 64!");
+  gf2_crc c;
+  c.generator = generator;
+  c.width = degree(generator);
+  const uint64_t mask = gf2_crc_mask(c.width);
+  c.init = init & mask;
+  c.reflect_in = reflect_in;
+  c.reflect_out = reflect_out;
+  c.xor_out = xor_out & mask;
+  c.modulus = make_gf2_modulus(generator);
+  const uint64_t low = generator.words[0] & mask;
+  c.tables.resize(16*256);
+  uint64_t* t = c.tables.data();
+  if (reflect_in) {
+    const uint64_t p = gf2_crc_reflect(low, c.width);
+    for (uint64_t i = 0; i < 256; ++i) {
+      uint64_t r = i;
+      for (int j = 0; j < 8; ++j)
+        r = (r & 1) ? (r >> 1) ^ p : r >> 1;
+      t[i] = r;
+    }
+    for (size_t k = 1; k < 16; ++k) {
+      for (size_t i = 0; i < 256; ++i)
+        t[256*k + i] = (t[256*(k-1) + i] >> 8) ^ t[t[256*(k-1) + i] & 0xff];
+    }
+  } else {
+    const uint64_t p = low << (64 - c.width);
+    for (uint64_t i = 0; i < 256; ++i) {
+      uint64_t r = i << 56;
+      for (int j = 0; j < 8; ++j)
+        r = (r >> 63) ? (r << 1) ^ p : r << 1;
+      t[i] = r;
+    }
+    for (size_t k = 1; k < 16; ++k) {
+      for (size_t i = 0; i < 256; ++i)
+        t[256*k + i] = (t[256*(k-1) + i] << 8) ^ t[t[256*(k-1) + i] >> 56];
+    }
+  }
+  /*
+  A 128 bit lane A = A1*x^64 + A0 moves forward by d bits as A1*(x^(d+64) mod g) + A0*(x^d mod g), both products below x^128.
+  Reflected lanes hold the bit reversed halves, and the product of two bit reversed 64 bit words is the reversed product
+  shifted down by one, so their constants are the reversed x^(d+63) mod g and x^(d-1) mod g.
+  */
+  for (int j = 0; j < 4; ++j) {
+    const uint64_t d = 128*(uint64_t)(j+1);
+    if (reflect_in) {
+      c.fold[j][0] = gf2_bit_reverse64(gf2_crc_xn_mod(d+63, c));
+      c.fold[j][1] = gf2_bit_reverse64(gf2_crc_xn_mod(d-1, c));
+    } else {
+      c.fold[j][0] = gf2_crc_xn_mod(d, c);
+      c.fold[j][1] = gf2_crc_xn_mod(d+64, c);
+    }
+  }
+  return c;
+}
+
+// the register from a checksum value, and back, see the orientation above
+inline uint64_t gf2_crc_register(const gf2_crc& c, uint64_t value) {
+  uint64_t p = (value ^ c.xor_out) & gf2_crc_mask(c.width);
+  if (c.reflect_out)
+    p = gf2_crc_reflect(p, c.width);
+  return c.reflect_in ? gf2_crc_reflect(p, c.width) : p << (64 - c.width);
+}
+
+inline uint64_t gf2_crc_value(const gf2_crc& c, uint64_t reg) {
+  uint64_t p = c.reflect_in ? gf2_crc_reflect(reg, c.width) : reg >> (64 - c.width);
+  if (c.reflect_out)
+    p = gf2_crc_reflect(p, c.width);
+  return p ^ c.xor_out;
+}
+
+// written out so that compilers merge them into one load, with a byte swap for big endian
+inline uint64_t gf2_crc_load_le64(const uint8_t* p) {
+  return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+    (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
+
+inline uint64_t gf2_crc_load_be64(const uint8_t* p) {
+  return (uint64_t)p[0] << 56 | (uint64_t)p[1] << 48 | (uint64_t)p[2] << 40 | (uint64_t)p[3] << 32 |
+    (uint64_t)p[4] << 24 | (uint64_t)p[5] << 16 | (uint64_t)p[6] << 8 | (uint64_t)p[7];
+}
+
+inline uint64_t gf2_crc_update_bytewise(const gf2_crc& c, uint64_t reg, const uint8_t* p, size_t len) {
+  const uint64_t* t = c.tables.data();
+  if (c.reflect_in) {
+    for (size_t i = 0; i < len; ++i)
+      reg = (reg >> 8) ^ t[(reg ^ p[i]) & 0xff];
+  } else {
+    for (size_t i = 0; i < len; ++i)
+      reg = (reg << 8) ^ t[(reg >> 56) ^ p[i]];
+  }
+  return reg;
+}
+
+// the 8 table lookups of one word v, tables t+256*7 down to t, earliest byte first
+template <bool reflected>
+inline uint64_t gf2_crc_slice8(const uint64_t* t, uint64_t v) {
+  if (reflected)
+    return t[256*7 + (v & 0xff)] ^ t[256*6 + ((v >> 8) & 0xff)] ^ t[256*5 + ((v >> 16) & 0xff)] ^ t[256*4 + ((v >> 24) & 0xff)] ^
+      t[256*3 + ((v >> 32) & 0xff)] ^ t[256*2 + ((v >> 40) & 0xff)] ^ t[256 + ((v >> 48) & 0xff)] ^ t[v >> 56];
+  return t[256*7 + (v >> 56)] ^ t[256*6 + ((v >> 48) & 0xff)] ^ t[256*5 + ((v >> 40) & 0xff)] ^ t[256*4 + ((v >> 32) & 0xff)] ^
+    t[256*3 + ((v >> 24) & 0xff)] ^ t[256*2 + ((v >> 16) & 0xff)] ^ t[256 + ((v >> 8) & 0xff)] ^ t[v & 0xff];
+}
+
+template <bool reflected>
+inline uint64_t gf2_crc_load64(const uint8_t* p) {
+  return reflected ? gf2_crc_load_le64(p) : gf2_crc_load_be64(p);
+}
+
+// the orientation is a template parameter so that the loops carry no branch on it
+template <bool reflected>
+inline uint64_t gf2_crc_slicing_loop(const uint64_t* t, uint64_t reg, const uint8_t*& p, size_t& len, bool by_16) {
+  if (by_16) {
+    for (; len >= 16; p += 16, len -= 16)
+      reg = gf2_crc_slice8<reflected>(t + 256*8, reg ^ gf2_crc_load64<reflected>(p)) ^ gf2_crc_slice8<reflected>(t, gf2_crc_load64<reflected>(p+8));
+  }
+  for (; len >= 8; p += 8, len -= 8)
+    reg = gf2_crc_slice8<reflected>(t, reg ^ gf2_crc_load64<reflected>(p));
+  return reg;
+}
+
+inline uint64_t gf2_crc_update_slicing(const gf2_crc& c, uint64_t reg, const uint8_t* p, size_t len, bool by_16) {
+  const uint64_t* t = c.tables.data();
+  reg = c.reflect_in ? gf2_crc_slicing_loop<true>(t, reg, p, len, by_16) : gf2_crc_slicing_loop<false>(t, reg, p, len, by_16);
+  return gf2_crc_update_bytewise(c, reg, p, len);
+}
+
+#if defined(GF2_X86_INTRINSICS)
+GF2_TARGET("pclmul,ssse3") inline __m128i gf2_crc_fold128(__m128i a, __m128i k) {
+  return _mm_xor_si128(_mm_clmulepi64_si128(a, k, 0x00), _mm_clmulepi64_si128(a, k, 0x11));
+}
+
+// 16 message bytes as a lane: as loaded for reflected input, as the 128 bit big endian number otherwise
+GF2_TARGET("pclmul,ssse3") inline __m128i gf2_crc_load_lane(const uint8_t* p, bool reflected) {
+  const __m128i v = _mm_loadu_si128((const __m128i*)p);
+  return reflected ? v : _mm_shuffle_epi8(v, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+/*
+Folds 16*blocks bytes, blocks >= 4, with the register added to the first lane, into 16 bytes in message order
+that leave the same register as the input when run through the tables from a zero register.
+*/
+GF2_TARGET("pclmul,ssse3") inline void gf2_crc_fold_pclmul(const gf2_crc& c, uint64_t reg, const uint8_t* p, size_t blocks, uint8_t folded[16]) {
+  const bool reflected = c.reflect_in;
+  __m128i k[4];
+  for (int j = 0; j < 4; ++j)
+    k[j] = _mm_set_epi64x((long long)c.fold[j][1], (long long)c.fold[j][0]);
+  __m128i a0 = gf2_crc_load_lane(p, reflected);
+  __m128i a1 = gf2_crc_load_lane(p+16, reflected);
+  __m128i a2 = gf2_crc_load_lane(p+32, reflected);
+  __m128i a3 = gf2_crc_load_lane(p+48, reflected);
+  // the register times x^(128-w) sits at the top of the first lane
+  a0 = _mm_xor_si128(a0, reflected ? _mm_set_epi64x(0, (long long)reg) : _mm_set_epi64x((long long)reg, 0));
+  p += 64;
+  blocks -= 4;
+  for (; blocks >= 4; p += 64, blocks -= 4) {
+    a0 = _mm_xor_si128(gf2_crc_fold128(a0, k[3]), gf2_crc_load_lane(p, reflected));
+    a1 = _mm_xor_si128(gf2_crc_fold128(a1, k[3]), gf2_crc_load_lane(p+16, reflected));
+    a2 = _mm_xor_si128(gf2_crc_fold128(a2, k[3]), gf2_crc_load_lane(p+32, reflected));
+    a3 = _mm_xor_si128(gf2_crc_fold128(a3, k[3]), gf2_crc_load_lane(p+48, reflected));
+  }
+  __m128i a = _mm_xor_si128(_mm_xor_si128(gf2_crc_fold128(a0, k[2]), gf2_crc_fold128(a1, k[1])), _mm_xor_si128(gf2_crc_fold128(a2, k[0]), a3));
+  for (; blocks > 0; p += 16, --blocks)
+    a = _mm_xor_si128(gf2_crc_fold128(a, k[0]), gf2_crc_load_lane(p, reflected));
+  // the lane layout is its own inverse
+  _mm_storeu_si128((__m128i*)folded, gf2_crc_load_lane((const uint8_t*)&a, reflected));
+}
+#endif
+
+inline bool gf2_crc_clmul_supported() {
+#if defined(GF2_X86_INTRINSICS)
+  return gf2_cpu().pclmul;
+#else
+  return false;
+#endif
+}
+
+// the register after the bytes p[0..len)
+inline uint64_t gf2_crc_update_register(const gf2_crc& c, uint64_t reg, const uint8_t* p, size_t len, gf2_crc_method method = gf2_crc_automatic) {
+  if (method == gf2_crc_automatic)
+    method = len >= 64 && gf2_crc_clmul_supported() ? gf2_crc_clmul : gf2_crc_slicing_by_16;
+  switch (method) {
+  case gf2_crc_bytewise:
+    return gf2_crc_update_bytewise(c, reg, p, len);
+  case gf2_crc_slicing_by_8:
+    return gf2_crc_update_slicing(c, reg, p, len, false);
+  case gf2_crc_clmul:
+#if defined(GF2_X86_INTRINSICS)
+    if (len >= 64 && gf2_crc_clmul_supported()) {
+      uint8_t folded[16];
+      const size_t blocks = len/16;
+      gf2_crc_fold_pclmul(c, reg, p, blocks, folded);
+      reg = gf2_crc_update_slicing(c, 0, folded, 16, true);
+      return gf2_crc_update_slicing(c, reg, p + 16*blocks, len - 16*blocks, true);
+    }
+#endif
+    return gf2_crc_update_slicing(c, reg, p, len, true);
+  default:
+    return gf2_crc_update_slicing(c, reg, p, len, true);
+  }
+}
+
+// the checksum of the empty message
+inline uint64_t gf2_crc_initial(const gf2_crc& c) {
+  return gf2_crc_value(c, c.reflect_in ? gf2_crc_reflect(c.init, c.width) : c.init << (64 - c.width));
+}
+
+// the checksum of a message continued by len bytes, given the checksum of the message so far
+inline uint64_t gf2_crc_update(const gf2_crc& c, uint64_t crc, const void* data, size_t len, gf2_crc_method method = gf2_crc_automatic) {
+  const uint64_t reg = gf2_crc_update_register(c, gf2_crc_register(c, crc), (const uint8_t*)data, len, method);
+  return gf2_crc_value(c, reg);
+}
+
+inline uint64_t gf2_crc_compute(const gf2_crc& c, const void* data, size_t len, gf2_crc_method method = gf2_crc_automatic) {
+  return gf2_crc_update(c, gf2_crc_initial(c), data, len, method);
+}
+
+/*
+The checksum of a message a followed by a message b from the checksums of both and the length of b.
+With registers as polynomials, the register of ab is (r_a + init)*x^(8*len_b) + r_b mod g,
+so parts of a large input can be checked in parallel and combined in O(log len_b) modular products.
+*/
+inline uint64_t gf2_crc_combine(const gf2_crc& c, uint64_t crc_a, uint64_t crc_b, uint64_t len_b) {
+  const uint64_t mask = gf2_crc_mask(c.width);
+  auto to_polynomial = [&](uint64_t value) {
+    uint64_t p = (value ^ c.xor_out) & mask;
+    return make_gf2_polynomial_from_words(std::vector<uint64_t>(1, c.reflect_out ? gf2_crc_reflect(p, c.width) : p));
+  };
+  gf2_polynomial r = to_polynomial(crc_a) + make_gf2_polynomial_from_words(std::vector<uint64_t>(1, c.init));
+  const gf2_polynomial shift = powmod(make_xn(8), len_b, c.modulus);
+  mulmod_into(r, r, shift, c.modulus);
+  r += to_polynomial(crc_b);
+  uint64_t p = is_zero(r) ? 0 : r.words[0];
+  if (c.reflect_out)
+    p = gf2_crc_reflect(p, c.width);
+  return p ^ c.xor_out;
+}
+
+// common parameter sets, with the checksum of "123456789" in the comment
+inline const gf2_crc& gf2_crc32() {
+  // 0xcbf43926
+  static const gf2_crc c = make_gf2_crc(hex_to_gf2_polynomial("104c11db7"), 0xffffffff, true, true, 0xffffffff);
+  return c;
+}
+
+inline const gf2_crc& gf2_crc32c() {
+  // 0xe3069283
+  static const gf2_crc c = make_gf2_crc(hex_to_gf2_polynomial("11edc6f41"), 0xffffffff, true, true, 0xffffffff);
+  return c;
+}
+
+inline const gf2_crc& gf2_crc64_xz() {
+  // 0x995dc9bbdf1939fa
+  static const gf2_crc c = make_gf2_crc(hex_to_gf2_polynomial("142f0e1eba9ea3693"), ~(uint64_t)0, true, true, ~(uint64_t)0);
+  return c;
+}
+
+inline const gf2_crc& gf2_crc64_ecma182() {
+  // 0x6c40df5f0b497347
+  static const gf2_crc c = make_gf2_crc(hex_to_gf2_polynomial("142f0e1eba9ea3693"), 0, false, false, 0);
+  return c;
+}
+
+inline const gf2_crc& gf2_crc16_ccitt_false() {
+  // 0x29b1
+  static const gf2_crc c = make_gf2_crc(hex_to_gf2_polynomial("11021"), 0xffff, false, false, 0);
+  return c;
+}
+
+#endif
@@ -0,0 +1,372 @@
+#ifndef GF2_FFT_H
+#define GF2_FFT_H
+
+#include "gf2_words.h"
+
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/*
+Quasi-linear multiplication in GF(2)[x] with an additive FFT over GF(2^64).
+
+The operands are cut in 32 bit chunks that become the coefficients of polynomials over GF(2^64).
+Products of two chunks have degree at most 62, so the product over GF(2^64) never wraps
+around the field modulus and gives the GF(2)[x] product back exactly.
+
+The transform is the one from Lin, Chung and Han, "Novel polynomial basis and its application to
+Reed-Solomon erasure codes" (2014), on a Cantor basis b1 = 1, b(i+1)^2 + b(i+1) = bi as in
+Chen, Cheng, Kuo, Li and Yang, "Faster multiplication for long binary polynomials" (2017).
+With w_i = sum of b(j+1) over the bits j of i, the subspace polynomial s_k(x) = prod(x - w_i), i < 2^k,
+equals sum over binom(k,i) odd of x^(2^i) and s_k(b(k+1)) = 1, which keeps the butterflies simple:
+  - evaluating at w_(2^m*j) + span(b1..bm) needs the twiddle s_(m-1)(w_(2^m*j)) = w_(2j)
+  - the conversion to the novel basis X_i = prod s_j over the bits j of i only divides by the sparse s_k.
+*/
+
+// GF(2^64) = GF(2)[x]/(x^64 + x^4 + x^3 + x + 1)
+inline uint64_t gf2_gf64_reduce(uint64_t lo, uint64_t hi) {
+  lo ^= hi ^ (hi << 1) ^ (hi << 3) ^ (hi << 4);
+  uint64_t t = (hi >> 63) ^ (hi >> 61) ^ (hi >> 60);
+  return lo ^ t ^ (t << 1) ^ (t << 3) ^ (t << 4);
+}
+
+inline uint64_t gf2_gf64_mul(uint64_t a, uint64_t b) {
+  uint64_t hi;
+  uint64_t lo = gf2_clmul64(a, b, hi);
+  return gf2_gf64_reduce(lo, hi);
+}
+
+inline void gf2_gf64_mul_xor_portable(uint64_t* u, const uint64_t* v, uint64_t t, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t hi;
+    uint64_t lo = gf2_clmul64_portable(t, v[i], hi);
+    u[i] ^= gf2_gf64_reduce(lo, hi);
+  }
+}
+
+inline void gf2_gf64_mul_pointwise_portable(uint64_t* a, const uint64_t* b, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t hi;
+    uint64_t lo = gf2_clmul64_portable(a[i], b[i], hi);
+    a[i] = gf2_gf64_reduce(lo, hi);
+  }
+}
+
+#if defined(GF2_X86_INTRINSICS)
+
+GF2_TARGET("pclmul,sse2") inline void gf2_gf64_mul_xor_pclmul(uint64_t* u, const uint64_t* v, uint64_t t, size_t n) {
+  const __m128i tt = _mm_cvtsi64_si128((long long)t);
+  for (size_t i = 0; i < n; ++i) {
+    __m128i p = _mm_clmulepi64_si128(tt, _mm_cvtsi64_si128((long long)v[i]), 0x00);
+    uint64_t lo = (uint64_t)_mm_cvtsi128_si64(p);
+    uint64_t hi = (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p));
+    u[i] ^= gf2_gf64_reduce(lo, hi);
+  }
+}
+
+GF2_TARGET("pclmul,sse2") inline void gf2_gf64_mul_pointwise_pclmul(uint64_t* a, const uint64_t* b, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    __m128i p = _mm_clmulepi64_si128(_mm_cvtsi64_si128((long long)a[i]), _mm_cvtsi64_si128((long long)b[i]), 0x00);
+    uint64_t lo = (uint64_t)_mm_cvtsi128_si64(p);
+    uint64_t hi = (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p));
+    a[i] = gf2_gf64_reduce(lo, hi);
+  }
+}
+
+/*
+The shifts and unpacks use their zero masking forms with a full mask: the plain ones expand in GCC 12 to the
+merge masking builtins with an undefined source, which -Wmaybe-uninitialized reports.
+*/
+GF2_TARGET("avx512f,vpclmulqdq") inline __m512i gf2_gf64_reduce_avx512(__m512i even, __m512i odd) {
+  const __mmask8 all = 0xff;
+  // even holds the products of the even elements in its 128 bit lanes, odd those of the odd elements
+  __m512i lo = _mm512_maskz_unpacklo_epi64(all, even, odd);
+  __m512i hi = _mm512_maskz_unpackhi_epi64(all, even, odd);
+  lo = _mm512_xor_si512(lo, _mm512_xor_si512(_mm512_xor_si512(hi, _mm512_maskz_slli_epi64(all, hi, 1)),
+    _mm512_xor_si512(_mm512_maskz_slli_epi64(all, hi, 3), _mm512_maskz_slli_epi64(all, hi, 4))));
+  __m512i t = _mm512_xor_si512(_mm512_xor_si512(_mm512_maskz_srli_epi64(all, hi, 63), _mm512_maskz_srli_epi64(all, hi, 61)),
+    _mm512_maskz_srli_epi64(all, hi, 60));
+  return _mm512_xor_si512(lo, _mm512_xor_si512(_mm512_xor_si512(t, _mm512_maskz_slli_epi64(all, t, 1)),
+    _mm512_xor_si512(_mm512_maskz_slli_epi64(all, t, 3), _mm512_maskz_slli_epi64(all, t, 4))));
+}
+
+GF2_TARGET("avx512f,vpclmulqdq") inline void gf2_gf64_mul_xor_vpclmul(uint64_t* u, const uint64_t* v, uint64_t t, size_t n) {
+  const __m512i tt = _mm512_set1_epi64((long long)t);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i vi = _mm512_loadu_si512((const void*)(v + i));
+    __m512i p = gf2_gf64_reduce_avx512(_mm512_clmulepi64_epi128(tt, vi, 0x00), _mm512_clmulepi64_epi128(tt, vi, 0x10));
+    _mm512_storeu_si512((void*)(u + i), _mm512_xor_si512(_mm512_loadu_si512((const void*)(u + i)), p));
+  }
+  gf2_gf64_mul_xor_pclmul(u + i, v + i, t, n - i);
+}
+
+GF2_TARGET("avx512f,vpclmulqdq") inline void gf2_gf64_mul_pointwise_vpclmul(uint64_t* a, const uint64_t* b, size_t n) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512i ai = _mm512_loadu_si512((const void*)(a + i));
+    __m512i bi = _mm512_loadu_si512((const void*)(b + i));
+    __m512i p = gf2_gf64_reduce_avx512(_mm512_clmulepi64_epi128(ai, bi, 0x00), _mm512_clmulepi64_epi128(ai, bi, 0x11));
+    _mm512_storeu_si512((void*)(a + i), p);
+  }
+  gf2_gf64_mul_pointwise_pclmul(a + i, b + i, n - i);
+}
+
+#endif
+
+// u[i] += t*v[i]
+inline void gf2_gf64_mul_xor(uint64_t* u, const uint64_t* v, uint64_t t, size_t n, bool pclmul, bool vpclmul) {
+#if defined(GF2_X86_INTRINSICS)
+  if (vpclmul) {
+    gf2_gf64_mul_xor_vpclmul(u, v, t, n);
+    return;
+  }
+  if (pclmul) {
+    gf2_gf64_mul_xor_pclmul(u, v, t, n);
+    return;
+  }
+#else
+  (void)pclmul;
+  (void)vpclmul;
+#endif
+  gf2_gf64_mul_xor_portable(u, v, t, n);
+}
+
+// a[i] *= b[i]
+inline void gf2_gf64_mul_pointwise(uint64_t* a, const uint64_t* b, size_t n, bool pclmul, bool vpclmul) {
+#if defined(GF2_X86_INTRINSICS)
+  if (vpclmul) {
+    gf2_gf64_mul_pointwise_vpclmul(a, b, n);
+    return;
+  }
+  if (pclmul) {
+    gf2_gf64_mul_pointwise_pclmul(a, b, n);
+    return;
+  }
+#else
+  (void)pclmul;
+  (void)vpclmul;
+#endif
+  gf2_gf64_mul_pointwise_portable(a, b, n);
+}
+
+/*
+Solves y^2 + y = c over GF(2^64). The map y -> y^2 + y is linear over GF(2) with kernel {0, 1},
+so this is a 64x64 linear system. Throws if c has trace 1 (no solution).
+*/
+inline uint64_t gf2_gf64_solve_quadratic(uint64_t c) {
+  uint64_t rows[64];
+  int rhs[64];
+  for (int j = 0; j < 64; ++j) {
+    rows[j] = 0;
+    rhs[j] = (int)((c >> j) & 1);
+  }
+  for (int i = 0; i < 64; ++i) {
+    uint64_t e = (uint64_t)1 << i;
+    uint64_t col = gf2_gf64_mul(e, e) ^ e;
+    for (int j = 0; j < 64; ++j)
+      if ((col >> j) & 1)
+        rows[j] |= e;
+  }
+  int pivot_row_of_col[64];
+  int rank = 0;
+  for (int i = 0; i < 64; ++i) {
+    pivot_row_of_col[i] = -1;
+    int p = -1;
+    for (int j = rank; j < 64; ++j)
+      if ((rows[j] >> i) & 1) {
+        p = j;
+        break;
+      }
+    if (p < 0)
+      continue;
+    std::swap(rows[p], rows[rank]);
+    std::swap(rhs[p], rhs[rank]);
+    for (int j = 0; j < 64; ++j)
+      if (j != rank && ((rows[j] >> i) & 1)) {
+        rows[j] ^= rows[rank];
+        rhs[j] ^= rhs[rank];
+      }
+    pivot_row_of_col[i] = rank;
+    ++rank;
+  }
+  for (int j = rank; j < 64; ++j)
+    if (rhs[j])
+      throw std::runtime_error("gf2_gf64_solve_quadratic: no solution!");
+  uint64_t y = 0;
+  for (int i = 0; i < 64; ++i)
+    if (pivot_row_of_col[i] >= 0 && rhs[pivot_row_of_col[i]])
+      y |= (uint64_t)1 << i;
+  return y;
+}
+
+// beta[i] is the Cantor basis element b(i+1)
+inline const uint64_t* gf2_cantor_basis() {
+  struct basis {
+    uint64_t beta[64];
+    basis() {
+      beta[0] = 1;
+      for (int i = 1; i < 64; ++i)
+        beta[i] = gf2_gf64_solve_quadratic(beta[i-1]);
+    }
+  };
+  static const basis b;
+  return b.beta;
+}
+
+// twiddles w_(2j) for j < n/2
+inline std::vector<uint64_t> gf2_fft_twiddles(size_t n) {
+  const uint64_t* beta = gf2_cantor_basis();
+  std::vector<uint64_t> w(n/2 > 0 ? n/2 : 1, 0);
+  for (size_t j = 1; j < w.size(); ++j)
+    w[j] = w[j & (j-1)] ^ beta[gf2_ctz64(j)+1];
+  return w;
+}
+
+// the twiddles of gf2_fft_twiddles(2^log_n), built once per log_n and shared by all threads
+inline const uint64_t* gf2_fft_cached_twiddles(int log_n) {
+  static std::vector<uint64_t> tables[64];
+  static std::once_flag built[64];
+  std::call_once(built[log_n], [log_n] { tables[log_n] = gf2_fft_twiddles((size_t)1 << log_n); });
+  return tables[log_n].data();
+}
+
+// the transform buffers of the calling thread, they keep their capacity between products
+inline std::vector<uint64_t>& gf2_fft_scratch(int i) {
+  static thread_local std::vector<uint64_t> buffers[2];
+  return buffers[i];
+}
+
+// monomial basis -> novel basis, in place, n = 2^log_n: recursively divide by s_(m-1)
+inline void gf2_fft_to_novel_basis(uint64_t* f, int log_n) {
+  const size_t n = (size_t)1 << log_n;
+  for (int m = log_n; m >= 1; --m) {
+    const size_t half = (size_t)1 << (m-1);
+    size_t offsets[64];
+    int terms = 0;
+    for (int i = 0; i < m-1; ++i)
+      if (((m-1) & i) == i)
+        offsets[terms++] = half - ((size_t)1 << i);
+    for (size_t base = 0; base < n; base += 2*half) {
+      uint64_t* g = f + base;
+      for (size_t p = 2*half; p-- > half;) {
+        const uint64_t v = g[p];
+        if (v == 0)
+          continue;
+        for (int t = 0; t < terms; ++t)
+          g[p - offsets[t]] ^= v;
+      }
+    }
+  }
+}
+
+// novel basis -> monomial basis, in place, the steps of gf2_fft_to_novel_basis in reverse order
+inline void gf2_fft_from_novel_basis(uint64_t* f, int log_n) {
+  const size_t n = (size_t)1 << log_n;
+  for (int m = 1; m <= log_n; ++m) {
+    const size_t half = (size_t)1 << (m-1);
+    size_t offsets[64];
+    int terms = 0;
+    for (int i = 0; i < m-1; ++i)
+      if (((m-1) & i) == i)
+        offsets[terms++] = half - ((size_t)1 << i);
+    for (size_t base = 0; base < n; base += 2*half) {
+      uint64_t* g = f + base;
+      for (size_t p = half; p < 2*half; ++p) {
+        const uint64_t v = g[p];
+        if (v == 0)
+          continue;
+        for (int t = 0; t < terms; ++t)
+          g[p - offsets[t]] ^= v;
+      }
+    }
+  }
+}
+
+// evaluates the novel basis polynomial f at w_0, ..., w_(n-1), in place
+inline void gf2_fft_forward(uint64_t* f, int log_n, const uint64_t* twiddles, bool pclmul, bool vpclmul) {
+  const size_t n = (size_t)1 << log_n;
+  for (int m = log_n; m >= 1; --m) {
+    const size_t half = (size_t)1 << (m-1);
+    for (size_t base = 0, j = 0; base < n; base += 2*half, ++j) {
+      uint64_t* u = f + base;
+      uint64_t* v = u + half;
+      if (twiddles[j])
+        gf2_gf64_mul_xor(u, v, twiddles[j], half, pclmul, vpclmul);
+      for (size_t i = 0; i < half; ++i)
+        v[i] ^= u[i];
+    }
+  }
+}
+
+inline void gf2_fft_inverse(uint64_t* f, int log_n, const uint64_t* twiddles, bool pclmul, bool vpclmul) {
+  const size_t n = (size_t)1 << log_n;
+  for (int m = 1; m <= log_n; ++m) {
+    const size_t half = (size_t)1 << (m-1);
+    for (size_t base = 0, j = 0; base < n; base += 2*half, ++j) {
+      uint64_t* u = f + base;
+      uint64_t* v = u + half;
+      for (size_t i = 0; i < half; ++i)
+        v[i] ^= u[i];
+      if (twiddles[j])
+        gf2_gf64_mul_xor(u, v, twiddles[j], half, pclmul, vpclmul);
+    }
+  }
+}
+
+/*
+r = a*b, r has na+nb words and does not alias a or b.
+The transforms need 2^ceil(log2(2*(na+nb))) field elements per operand, 4 times the words of the product.
+They run in two per-thread buffers that are reused from one product to the next, a square needs only the first,
+and the twiddles come from a cache, so a product allocates only when it is larger than any before it on its thread.
+The result is written straight into r.
+*/
+inline void gf2_words_mul_fft(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb, bool pclmul, bool vpclmul) {
+  const size_t chunks = 2*(na+nb);
+  int log_n = 1;
+  while (((size_t)1 << log_n) < chunks)
+    ++log_n;
+  const size_t n = (size_t)1 << log_n;
+  const bool square = (a == b && na == nb);
+  std::vector<uint64_t>& fa = gf2_fft_scratch(0);
+  fa.assign(n, 0);
+  for (size_t i = 0; i < na; ++i) {
+    fa[2*i] = a[i] & 0xffffffffULL;
+    fa[2*i+1] = a[i] >> 32;
+  }
+  const uint64_t* twiddles = gf2_fft_cached_twiddles(log_n);
+  gf2_fft_to_novel_basis(fa.data(), log_n);
+  gf2_fft_forward(fa.data(), log_n, twiddles, pclmul, vpclmul);
+  if (square) {
+    gf2_gf64_mul_pointwise(fa.data(), fa.data(), n, pclmul, vpclmul);
+  } else {
+    std::vector<uint64_t>& fb = gf2_fft_scratch(1);
+    fb.assign(n, 0);
+    for (size_t i = 0; i < nb; ++i) {
+      fb[2*i] = b[i] & 0xffffffffULL;
+      fb[2*i+1] = b[i] >> 32;
+    }
+    gf2_fft_to_novel_basis(fb.data(), log_n);
+    gf2_fft_forward(fb.data(), log_n, twiddles, pclmul, vpclmul);
+    gf2_gf64_mul_pointwise(fa.data(), fb.data(), n, pclmul, vpclmul);
+  }
+  gf2_fft_inverse(fa.data(), log_n, twiddles, pclmul, vpclmul);
+  gf2_fft_from_novel_basis(fa.data(), log_n);
+  const size_t nr = na+nb;
+  for (size_t i = 0; i < nr; ++i)
+    r[i] = 0;
+  for (size_t j = 0; j < chunks; ++j) {
+    const uint64_t v = fa[j];
+    const size_t w = j >> 1;
+    if (j & 1) {
+      r[w] ^= v << 32;
+      if (w+1 < nr)
+        r[w+1] ^= v >> 32;
+    } else {
+      r[w] ^= v;
+    }
+  }
+}
+
+#endif
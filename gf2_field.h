@@ -0,0 +1,200 @@
+#ifndef GF2_FIELD_H
+#define GF2_FIELD_H
+
+#include "gf2_poly_fixed.h"
+
+#include <stdexcept>
+#include <vector>
+
+/*
+Arithmetic in the binary field GF(2^m) = GF(2)[x]/(f) for an irreducible f of degree m <= N.
+Elements are gf2_poly_fixed<N> of degree < m, so no operation allocates, and addition is the xor of gf2_poly_fixed.
+For m <= 16 products, inverses and powers are lookups in log / antilog tables of a generator of the multiplicative group,
+which is what Reed-Solomon and BCH codes over GF(2^8) or GF(2^16) need.
+Larger fields multiply with the carry-less word products and reduce by folding for trinomials and pentanomials,
+or with a Barrett constant for any other f.
+*/
+template <size_t N>
+struct gf2_field {
+  uint64_t m = 0;
+  gf2_polynomial f;
+  // f - x^m and x^(2m)/f - x^m, both of degree < m
+  gf2_poly_fixed<N> low;
+  gf2_poly_fixed<N> mu_low;
+  // the exponents below m of a low weight f, see gf2_sparse_terms, -1 for a dense f
+  int sparse_count = -1;
+  uint64_t sparse_terms[4] = {};
+  // for m <= 16: exp[i] = g^i for i < 2(2^m - 1) and log[exp[i]] = i
+  std::vector<uint16_t> exp;
+  std::vector<uint16_t> log;
+};
+
+// the coefficients of a below x^m, in N coefficients
+template <size_t N, size_t M>
+inline gf2_poly_fixed<N> gf2_field_truncate(const gf2_poly_fixed<M>& a, uint64_t m) {
+  gf2_poly_fixed<N> r;
+  for (size_t i = 0; i < gf2_poly_fixed<N>::word_count && i < gf2_poly_fixed<M>::word_count; ++i)
+    r.words[i] = a.words[i];
+  if (m < 64*gf2_poly_fixed<N>::word_count) {
+    r.words[m>>6] &= ((uint64_t)1 << (m&63)) - 1;
+    for (size_t i = (m>>6) + 1; i < gf2_poly_fixed<N>::word_count; ++i)
+      r.words[i] = 0;
+  }
+  return r;
+}
+
+// a mod f for deg(a) <= 2m-2, the product of two field elements
+template <size_t N>
+inline gf2_poly_fixed<N> reduce(gf2_poly_fixed<2*N-1> a, const gf2_field<N>& F) {
+  if (F.sparse_count >= 0) {
+    gf2_words_reduce_sparse(a.words, gf2_poly_fixed<2*N-1>::word_count, F.m, F.sparse_terms, F.sparse_count, nullptr);
+    return gf2_field_truncate<N>(a, F.m);
+  }
+  // Barrett: q = a/x^m * (x^m + mu_low)/x^m = hi + hi*mu_low/x^m, then a mod f = (a + q*(x^m + low)) mod x^m
+  const gf2_poly_fixed<N> hi = gf2_field_truncate<N>(div_xn(a, F.m), N);
+  const gf2_poly_fixed<N> q = hi + gf2_field_truncate<N>(div_xn(hi*F.mu_low, F.m), N);
+  return gf2_field_truncate<N>(a + q*F.low, F.m);
+}
+
+// a*b without the tables
+template <size_t N>
+inline gf2_poly_fixed<N> gf2_field_mul_reduce(const gf2_poly_fixed<N>& a, const gf2_poly_fixed<N>& b, const gf2_field<N>& F) {
+  return reduce(a*b, F);
+}
+
+inline bool gf2_field_uses_tables(uint64_t m) {
+  return m <= 16;
+}
+
+template <size_t N>
+inline gf2_field<N> make_gf2_field(const gf2_polynomial& f) {
+  if (is_zero(f) || degree(f) == 0 || degree(f) > N)
+    throw std::runtime_error("make_gf2_field: modulus does not fit!");
+  if (!is_irreducible(f))
+    throw std::runtime_error("make_gf2_field: modulus is not irreducible!");
+  gf2_field<N> F;
+  F.m = degree(f);
+  F.f = f;
+  F.low = make_gf2_poly_fixed<N>(f + make_xn(F.m));
+  F.mu_low = make_gf2_poly_fixed<N>(make_xn(2*F.m)/f + make_xn(F.m));
+  uint64_t terms[4];
+  F.sparse_count = gf2_sparse_terms(f, terms);
+  for (int j = 0; j < F.sparse_count; ++j)
+    F.sparse_terms[j] = terms[j];
+  if (!gf2_field_uses_tables(F.m))
+    return F;
+  // the first of x, x+1, x^2, ... whose powers run through all 2^m - 1 nonzero elements
+  const uint64_t order = ((uint64_t)1 << F.m) - 1;
+  F.exp.resize(2*order);
+  F.log.assign(order+1, 0);
+  for (uint64_t candidate = F.m > 1 ? 2 : 1; ; ++candidate) {
+    const gf2_poly_fixed<N> g = make_gf2_poly_fixed<N>(candidate);
+    gf2_poly_fixed<N> p = make_gf2_poly_fixed<N>(1);
+    uint64_t i = 0;
+    do {
+      F.exp[i++] = (uint16_t)p.words[0];
+      p = gf2_field_mul_reduce(p, g, F);
+    } while (p.words[0] != 1 && i < order);
+    if (i == order && p.words[0] == 1)
+      break;
+  }
+  for (uint64_t i = 0; i < order; ++i) {
+    F.exp[order + i] = F.exp[i];
+    F.log[F.exp[i]] = (uint16_t)i;
+  }
+  return F;
+}
+
+// the field element p mod f
+template <size_t N>
+inline gf2_poly_fixed<N> make_gf2_field_element(const gf2_polynomial& p, const gf2_field<N>& F) {
+  return make_gf2_poly_fixed<N>(p % F.f);
+}
+
+template <size_t N>
+inline gf2_poly_fixed<N> mul(const gf2_poly_fixed<N>& a, const gf2_poly_fixed<N>& b, const gf2_field<N>& F) {
+  if (!F.exp.empty()) {
+    if (a.words[0] == 0 || b.words[0] == 0)
+      return gf2_poly_fixed<N>();
+    return make_gf2_poly_fixed<N>(F.exp[(size_t)F.log[a.words[0]] + F.log[b.words[0]]]);
+  }
+  return gf2_field_mul_reduce(a, b, F);
+}
+
+template <size_t N>
+inline gf2_poly_fixed<N> square(const gf2_poly_fixed<N>& a, const gf2_field<N>& F) {
+  return mul(a, a, F);
+}
+
+// a^e, with 0^0 = 1
+template <size_t N>
+inline gf2_poly_fixed<N> power(const gf2_poly_fixed<N>& a, uint64_t e, const gf2_field<N>& F) {
+  const gf2_poly_fixed<N> one = make_gf2_poly_fixed<N>(1);
+  if (e == 0)
+    return one;
+  if (!F.exp.empty()) {
+    if (a.words[0] == 0)
+      return gf2_poly_fixed<N>();
+    const uint64_t order = ((uint64_t)1 << F.m) - 1;
+    return make_gf2_poly_fixed<N>(F.exp[(size_t)((F.log[a.words[0]]*(e % order)) % order)]);
+  }
+  gf2_poly_fixed<N> r = one;
+  for (int bit = 63 - gf2_clz64(e); bit >= 0; --bit) {
+    r = square(r, F);
+    if ((e >> bit) & 1)
+      r = mul(r, a, F);
+  }
+  return r;
+}
+
+/*
+1/a. Large fields use Itoh-Tsujii: 1/a = a^(2^m - 2) = (b_(m-1))^2 with b_k = a^(2^k - 1),
+b_2k = b_k^(2^k) * b_k and b_(k+1) = b_k^2 * a, so the bits of m-1 are walked with O(log m) multiplications and m squarings.
+*/
+template <size_t N>
+inline gf2_poly_fixed<N> inverse(const gf2_poly_fixed<N>& a, const gf2_field<N>& F) {
+  if (is_zero(a))
+    throw std::runtime_error("inverse: zero is not invertible!");
+  if (!F.exp.empty()) {
+    const uint64_t order = ((uint64_t)1 << F.m) - 1;
+    return make_gf2_poly_fixed<N>(F.exp[order - F.log[a.words[0]]]);
+  }
+  const uint64_t k = F.m - 1;
+  gf2_poly_fixed<N> b = a;
+  uint64_t done = 1;
+  for (int bit = 62 - gf2_clz64(k); bit >= 0; --bit) {
+    gf2_poly_fixed<N> t = b;
+    for (uint64_t i = 0; i < done; ++i)
+      t = square(t, F);
+    b = mul(t, b, F);
+    done *= 2;
+    if ((k >> bit) & 1) {
+      b = mul(square(b, F), a, F);
+      ++done;
+    }
+  }
+  return square(b, F);
+}
+
+/*
+Inverts all elements in place with Montgomery's trick: the prefix products are inverted with one inverse,
+then peeled off from the back, so n inverses cost one inverse and 3(n-1) multiplications.
+*/
+template <size_t N>
+inline void batch_inverse(std::vector<gf2_poly_fixed<N>>& elements, const gf2_field<N>& F) {
+  if (elements.empty())
+    return;
+  std::vector<gf2_poly_fixed<N>> prefix(elements.size());
+  prefix[0] = elements[0];
+  for (size_t i = 1; i < elements.size(); ++i)
+    prefix[i] = mul(prefix[i-1], elements[i], F);
+  gf2_poly_fixed<N> inv = inverse(prefix.back(), F);
+  for (size_t i = elements.size(); i-- > 1;) {
+    const gf2_poly_fixed<N> e = elements[i];
+    elements[i] = mul(inv, prefix[i-1], F);
+    inv = mul(inv, e, F);
+  }
+  elements[0] = inv;
+}
+
+#endif
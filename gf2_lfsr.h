@@ -0,0 +1,129 @@
+#ifndef GF2_LFSR_H
+#define GF2_LFSR_H
+
+#include "gf2_polynomial.h"
+
+#include <algorithm>
+#include <vector>
+
+/*
+Berlekamp-Massey synthesis of the shortest LFSR that generates a bit sequence s_0, s_1, ...
+The connection polynomial C(x) = 1 + c_1 x + ... + c_L x^L, L the linear complexity, satisfies
+s_n = c_1 s_(n-1) + ... + c_L s_(n-L) for all n >= L. Its reversal x^L C(1/x) is the characteristic polynomial,
+whose factorization gives the structure of the LFSR: the periods, and the decomposition into smaller LFSRs.
+
+The bits are pushed one at a time or as packed words, low bit first, and each costs O(L/64) word operations:
+the discrepancy is the parity of C and the last L+1 bits, a word at a time. To make that a plain and of two
+words, the sequence is stored backwards, s_n at bit cap-1-n of reversed, so that s_(n-i) lines up with c_i.
+When the sequence outgrows cap, the buffer is doubled and the old bits move to its high end.
+*/
+struct gf2_berlekamp_massey {
+  std::vector<uint64_t> reversed{0}; // the cap bits, then one zero word for the reads past the end
+  uint64_t n = 0; // number of bits pushed
+  uint64_t length = 0; // linear complexity L
+  uint64_t shift = 1; // C is updated with x^shift * B
+  uint64_t previous_length = 0; // degree bound of B
+  std::vector<uint64_t> c{1}; // the connection polynomial, at least L/64+1 words
+  std::vector<uint64_t> b{1}; // C before the last change of L
+  std::vector<uint64_t> t; // scratch
+};
+
+// number of bits the sequence buffer holds
+inline uint64_t gf2_berlekamp_massey_capacity(const gf2_berlekamp_massey& bm) {
+  return 64*(uint64_t)(bm.reversed.size()-1);
+}
+
+// grows the sequence buffer to hold at least bits bits, keeping the pushed ones at its high end
+inline void gf2_berlekamp_massey_reserve(gf2_berlekamp_massey& bm, uint64_t bits) {
+  const size_t old_words = bm.reversed.size()-1;
+  if (bits <= 64*(uint64_t)old_words)
+    return;
+  const size_t words = std::max((size_t)((bits+63)/64), 2*old_words);
+  std::vector<uint64_t> r(words+1, 0);
+  std::copy(bm.reversed.begin(), bm.reversed.begin() + old_words, r.begin() + (words - old_words));
+  bm.reversed.swap(r);
+}
+
+inline void gf2_berlekamp_massey_push(gf2_berlekamp_massey& bm, bool bit) {
+  if (bm.n == gf2_berlekamp_massey_capacity(bm))
+    gf2_berlekamp_massey_reserve(bm, bm.n+1);
+  const uint64_t q = gf2_berlekamp_massey_capacity(bm)-1-bm.n;
+  if (bit)
+    bm.reversed[q>>6] |= (uint64_t)1 << (q&63);
+
+  // the discrepancy: c_i s_(n-i) summed over i <= L, where s_(n-i) is bit q+i
+  const size_t nc = (size_t)(bm.length/64+1);
+  const uint64_t* r = bm.reversed.data() + (q>>6);
+  const unsigned s = (unsigned)(q&63);
+  uint64_t d = 0;
+  if (s == 0) {
+    for (size_t i = 0; i < nc; ++i)
+      d ^= bm.c[i] & r[i];
+  } else {
+    for (size_t i = 0; i < nc; ++i)
+      d ^= bm.c[i] & ((r[i] >> s) | (r[i+1] << (64-s)));
+  }
+  ++bm.n;
+  if ((gf2_popcount64(d) & 1) == 0) {
+    ++bm.shift;
+    return;
+  }
+
+  // C <- C + x^shift B, and when 2L < n+1 the length grows to n+1-L and B takes the old C
+  const size_t nb = (size_t)(bm.previous_length/64+1);
+  const uint64_t n = bm.n-1;
+  if (2*bm.length <= n) {
+    const uint64_t new_length = n+1-bm.length;
+    bm.t.assign(bm.c.begin(), bm.c.end());
+    bm.t.resize(std::max(bm.t.size(), (size_t)(new_length/64+2)), 0);
+    gf2_words_xor_shifted(bm.t.data(), bm.b.data(), nb, bm.shift);
+    bm.b.swap(bm.c);
+    bm.c.swap(bm.t);
+    bm.previous_length = bm.length;
+    bm.length = new_length;
+    bm.shift = 1;
+  } else {
+    gf2_words_xor_shifted(bm.c.data(), bm.b.data(), nb, bm.shift);
+    ++bm.shift;
+  }
+}
+
+// pushes the bits s_0..s_(bits-1) of the packed words, s_i at bit i&63 of words[i>>6]
+inline void gf2_berlekamp_massey_push(gf2_berlekamp_massey& bm, const uint64_t* words, uint64_t bits) {
+  gf2_berlekamp_massey_reserve(bm, bm.n + bits);
+  for (uint64_t i = 0; i < bits; ++i)
+    gf2_berlekamp_massey_push(bm, ((words[i>>6] >> (i&63)) & 1) != 0);
+}
+
+// pushes the bytes of a captured stream, low bit of every byte first
+inline void gf2_berlekamp_massey_push_bytes(gf2_berlekamp_massey& bm, const uint8_t* p, size_t len) {
+  gf2_berlekamp_massey_reserve(bm, bm.n + 8*(uint64_t)len);
+  for (size_t i = 0; i < len; ++i) {
+    for (int j = 0; j < 8; ++j)
+      gf2_berlekamp_massey_push(bm, ((p[i] >> j) & 1) != 0);
+  }
+}
+
+// C(x) for the bits pushed so far, its degree can be below the linear complexity
+inline gf2_polynomial connection_polynomial(const gf2_berlekamp_massey& bm) {
+  gf2_polynomial p;
+  p.words.assign(bm.c.begin(), bm.c.begin() + (size_t)(bm.length/64+1));
+  normalize(p);
+  return p;
+}
+
+// x^L C(1/x), the polynomial to factor: its degree is the linear complexity L
+inline gf2_polynomial characteristic_polynomial(const gf2_berlekamp_massey& bm) {
+  return reversal(connection_polynomial(bm), bm.length);
+}
+
+// the connection polynomial of the first bits bits of a packed sequence, low bit first
+inline gf2_polynomial berlekamp_massey(const std::vector<uint64_t>& words, uint64_t bits) {
+  if (bits > 64*(uint64_t)words.size())
+    throw std::runtime_error("berlekamp_massey: more bits than words!");
+  gf2_berlekamp_massey bm;
+  gf2_berlekamp_massey_push(bm, words.data(), bits);
+  return connection_polynomial(bm);
+}
+
+#endif
@@ -0,0 +1,230 @@
+#ifndef GF2_MATRIX_H
+#define GF2_MATRIX_H
+
+#include "gf2_words.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/*
+Dense matrices over GF(2), each row packed in stride words like the coefficients of a polynomial:
+entry (i, j) is bit (j&63) of word (j>>6) of row i. Bits beyond cols are kept zero.
+*/
+struct gf2_matrix {
+  size_t rows = 0;
+  size_t cols = 0;
+  size_t stride = 0;
+  std::vector<uint64_t> data;
+};
+
+inline gf2_matrix make_gf2_matrix(size_t rows, size_t cols) {
+  gf2_matrix m;
+  m.rows = rows;
+  m.cols = cols;
+  m.stride = (cols+63)/64;
+  m.data.assign(rows*m.stride, 0);
+  return m;
+}
+
+inline gf2_matrix make_identity_gf2_matrix(size_t n) {
+  gf2_matrix m = make_gf2_matrix(n, n);
+  for (size_t i = 0; i < n; ++i)
+    m.data[i*m.stride + (i>>6)] |= (uint64_t)1 << (i&63);
+  return m;
+}
+
+inline uint64_t* row(gf2_matrix& m, size_t i) {
+  return m.data.data() + i*m.stride;
+}
+
+inline const uint64_t* row(const gf2_matrix& m, size_t i) {
+  return m.data.data() + i*m.stride;
+}
+
+inline int get_bit(const gf2_matrix& m, size_t i, size_t j) {
+  return (int)((row(m, i)[j>>6] >> (j&63)) & 1);
+}
+
+inline void set_bit(gf2_matrix& m, size_t i, size_t j, int value) {
+  const uint64_t mask = (uint64_t)1 << (j&63);
+  if (value & 1)
+    row(m, i)[j>>6] |= mask;
+  else
+    row(m, i)[j>>6] &= ~mask;
+}
+
+inline void flip_bit(gf2_matrix& m, size_t i, size_t j) {
+  row(m, i)[j>>6] ^= (uint64_t)1 << (j&63);
+}
+
+inline void swap_rows(gf2_matrix& m, size_t i, size_t k) {
+  if (i != k)
+    std::swap_ranges(row(m, i), row(m, i) + m.stride, row(m, k));
+}
+
+inline bool operator == (const gf2_matrix& a, const gf2_matrix& b) {
+  return a.rows == b.rows && a.cols == b.cols && a.data == b.data;
+}
+
+inline bool operator != (const gf2_matrix& a, const gf2_matrix& b) {
+  return !(a == b);
+}
+
+inline gf2_matrix operator * (const gf2_matrix& a, const gf2_matrix& b) {
+  if (a.cols != b.rows)
+    throw std::runtime_error("gf2_matrix: dimension mismatch!");
+  gf2_matrix c = make_gf2_matrix(a.rows, b.cols);
+  for (size_t i = 0; i < a.rows; ++i) {
+    uint64_t* ci = row(c, i);
+    for (size_t j = 0; j < a.cols; ++j) {
+      if (get_bit(a, i, j)) {
+        const uint64_t* bj = row(b, j);
+        for (size_t w = 0; w < c.stride; ++w)
+          ci[w] ^= bj[w];
+      }
+    }
+  }
+  return c;
+}
+
+/*
+Row echelon form by plain Gaussian elimination, pivots are only searched in the first pivot_cols columns
+(all columns if pivot_cols is 0). Returns the rank, the pivot rows are the first rank rows.
+*/
+inline size_t echelon_form_gauss(gf2_matrix& m, size_t pivot_cols = 0) {
+  if (pivot_cols == 0 || pivot_cols > m.cols)
+    pivot_cols = m.cols;
+  size_t r = 0;
+  for (size_t c = 0; c < pivot_cols && r < m.rows; ++c) {
+    size_t p = r;
+    while (p < m.rows && !get_bit(m, p, c))
+      ++p;
+    if (p == m.rows)
+      continue;
+    swap_rows(m, r, p);
+    const uint64_t* pr = row(m, r);
+    for (size_t i = r+1; i < m.rows; ++i) {
+      if (get_bit(m, i, c)) {
+        uint64_t* ri = row(m, i);
+        for (size_t w = c>>6; w < m.stride; ++w)
+          ri[w] ^= pr[w];
+      }
+    }
+    ++r;
+  }
+  return r;
+}
+
+/*
+Row echelon form with the Method of Four Russians (M4RI, see Bard, Algebraic Cryptanalysis, ch. 9).
+Up to k pivots are found at a time, reduced to the identity on their pivot columns, and the 2^k sums of
+those pivot rows are tabulated, so clearing the k columns in every row below costs one table lookup and
+one row xor instead of up to k. Rows are only touched lazily while searching for pivots: the effective bit of
+a row in a column follows from its bits in the pivot columns found so far.
+Pivots are only searched in the first pivot_cols columns (all columns if pivot_cols is 0), k = 0 picks a
+block size from the matrix size. Returns the rank, the pivot rows are the first rank rows.
+*/
+inline size_t echelon_form_m4ri(gf2_matrix& m, size_t pivot_cols = 0, int k = 0) {
+  if (pivot_cols == 0 || pivot_cols > m.cols)
+    pivot_cols = m.cols;
+  if (k <= 0) {
+    k = 1;
+    while (k < 8 && ((size_t)4 << k) < m.rows)
+      ++k;
+  }
+  if (k > 16)
+    k = 16;
+  std::vector<uint64_t> table;
+  size_t pivot_col[16];
+  size_t r = 0;
+  size_t c = 0;
+  while (c < pivot_cols && r < m.rows) {
+    // find up to k pivots in the columns from c on, keeping them reduced among each other
+    int found = 0;
+    for (; c < pivot_cols && found < k && r + found < m.rows; ++c) {
+      size_t p = r + found;
+      for (; p < m.rows; ++p) {
+        const uint64_t* rp = row(m, p);
+        uint64_t bit = (rp[c>>6] >> (c&63)) & 1;
+        for (int f = 0; f < found; ++f)
+          bit ^= ((rp[pivot_col[f]>>6] >> (pivot_col[f]&63)) & 1) & get_bit(m, r+f, c);
+        if (bit)
+          break;
+      }
+      if (p == m.rows)
+        continue;
+      swap_rows(m, r + found, p);
+      uint64_t* rp = row(m, r + found);
+      for (int f = 0; f < found; ++f) {
+        if (get_bit(m, r + found, pivot_col[f])) {
+          const uint64_t* rf = row(m, r + f);
+          for (size_t w = 0; w < m.stride; ++w)
+            rp[w] ^= rf[w];
+        }
+      }
+      for (int f = 0; f < found; ++f) {
+        if (get_bit(m, r + f, c)) {
+          uint64_t* rf = row(m, r + f);
+          for (size_t w = 0; w < m.stride; ++w)
+            rf[w] ^= rp[w];
+        }
+      }
+      pivot_col[found++] = c;
+    }
+    if (found == 0)
+      break;
+    // table of all sums of the pivot rows, from the word of the first pivot column on
+    const size_t w0 = pivot_col[0] >> 6;
+    const size_t width = m.stride - w0;
+    const size_t entries = (size_t)1 << found;
+    table.assign(entries*width, 0);
+    for (size_t e = 1; e < entries; ++e) {
+      const int f = gf2_ctz64(e);
+      const uint64_t* prev = table.data() + (e & (e-1))*width;
+      const uint64_t* rf = row(m, r + f) + w0;
+      uint64_t* t = table.data() + e*width;
+      for (size_t w = 0; w < width; ++w)
+        t[w] = prev[w] ^ rf[w];
+    }
+    for (size_t i = r + found; i < m.rows; ++i) {
+      uint64_t* ri = row(m, i);
+      size_t e = 0;
+      for (int f = 0; f < found; ++f)
+        e |= (size_t)((ri[pivot_col[f]>>6] >> (pivot_col[f]&63)) & 1) << f;
+      if (e == 0)
+        continue;
+      const uint64_t* t = table.data() + e*width;
+      ri += w0;
+      for (size_t w = 0; w < width; ++w)
+        ri[w] ^= t[w];
+    }
+    r += found;
+  }
+  return r;
+}
+
+/*
+Basis of the left null space {v : v*a = 0}, one vector per row.
+The echelon form of [a | I] leaves the rows of the transformation that map to zero at the bottom.
+*/
+inline gf2_matrix left_nullspace(const gf2_matrix& a) {
+  if (a.cols == 0)
+    return make_identity_gf2_matrix(a.rows);
+  gf2_matrix aug = make_gf2_matrix(a.rows, a.cols + a.rows);
+  for (size_t i = 0; i < a.rows; ++i) {
+    std::copy(row(a, i), row(a, i) + a.stride, row(aug, i));
+    const size_t j = a.cols + i;
+    row(aug, i)[j>>6] |= (uint64_t)1 << (j&63);
+  }
+  const size_t rank = echelon_form_m4ri(aug, a.cols);
+  gf2_matrix n = make_gf2_matrix(a.rows - rank, a.rows);
+  for (size_t i = rank; i < a.rows; ++i)
+    for (size_t j = 0; j < a.rows; ++j)
+      if (get_bit(aug, i, a.cols + j))
+        set_bit(n, i - rank, j, 1);
+  return n;
+}
+
+#endif
@@ -0,0 +1,431 @@
+#ifndef GF2_MULTIPLICATION_H
+#define GF2_MULTIPLICATION_H
+
+#include "gf2_words.h"
+#include "gf2_fft.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/*
+Multiplication engine on packed coefficient words.
+All kernels compute r = a*b where r has na+nb words and does not alias a or b.
+The kernel is picked once with cpuid, gf2_set_mul_kernel can override it (not thread safe, call it at startup).
+Above the thresholds (in words of the shorter operand) the product recurses with Karatsuba and Toom-3,
+and switches to the additive FFT of gf2_fft.h for very large operands.
+*/
+
+
+struct gf2_mul_thresholds {
+  size_t karatsuba;
+  size_t toom3;
+  size_t fft;
+};
+
+enum gf2_mul_kernel {
+  gf2_mul_kernel_portable,
+  gf2_mul_kernel_pclmul,
+  gf2_mul_kernel_vpclmul
+};
+
+#if defined(GF2_X86_INTRINSICS)
+
+GF2_TARGET("pclmul,sse2") inline void gf2_words_mul_pclmul(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+  for (size_t i = 0; i < na + nb; ++i)
+    r[i] = 0;
+  for (size_t i = 0; i < na; ++i) {
+    if (a[i] == 0)
+      continue;
+    const __m128i ai = _mm_cvtsi64_si128((long long)a[i]);
+    uint64_t carry = 0;
+    for (size_t j = 0; j < nb; ++j) {
+      __m128i p = _mm_clmulepi64_si128(ai, _mm_cvtsi64_si128((long long)b[j]), 0x00);
+      r[i + j] ^= (uint64_t)_mm_cvtsi128_si64(p) ^ carry;
+      carry = (uint64_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(p, p));
+    }
+    r[i + nb] ^= carry;
+  }
+}
+
+/*
+Each vpclmulqdq multiplies a[i] with four words of b at once: selector 0x00 takes the even words b[j+2k],
+whose products land on r[i+j+2k], and selector 0x10 the odd words, whose products land one word higher.
+The odd products are moved up one word with valignq, the word falling out is carried into the next block.
+valignq is used in its zero masking form with a full mask, the plain one trips -Wmaybe-uninitialized in GCC 12.
+*/
+GF2_TARGET("avx512f,vpclmulqdq") inline void gf2_words_mul_vpclmul(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+  for (size_t i = 0; i < na + nb; ++i)
+    r[i] = 0;
+  const size_t full = nb & ~(size_t)7;
+  const unsigned rest = (unsigned)(nb - full);
+  const __mmask8 load_mask = (__mmask8)((1u << rest) - 1);
+  const __mmask8 store_mask = (__mmask8)((1u << (rest + 1)) - 1);
+  for (size_t i = 0; i < na; ++i) {
+    if (a[i] == 0)
+      continue;
+    const __m512i ai = _mm512_set1_epi64((long long)a[i]);
+    __m512i odd_prev = _mm512_setzero_si512();
+    uint64_t* ri = r + i;
+    size_t j = 0;
+    for (; j < full; j += 8) {
+      __m512i bj = _mm512_loadu_si512((const void*)(b + j));
+      __m512i even = _mm512_clmulepi64_epi128(ai, bj, 0x00);
+      __m512i odd = _mm512_clmulepi64_epi128(ai, bj, 0x10);
+      __m512i acc = _mm512_xor_si512(even, _mm512_maskz_alignr_epi64((__mmask8)0xff, odd, odd_prev, 7));
+      _mm512_storeu_si512((void*)(ri + j), _mm512_xor_si512(_mm512_loadu_si512((const void*)(ri + j)), acc));
+      odd_prev = odd;
+    }
+    __m512i bj = _mm512_maskz_loadu_epi64(load_mask, (const void*)(b + j));
+    __m512i even = _mm512_clmulepi64_epi128(ai, bj, 0x00);
+    __m512i odd = _mm512_clmulepi64_epi128(ai, bj, 0x10);
+    __m512i acc = _mm512_xor_si512(even, _mm512_maskz_alignr_epi64((__mmask8)0xff, odd, odd_prev, 7));
+    __m512i rj = _mm512_maskz_loadu_epi64(store_mask, (const void*)(ri + j));
+    _mm512_mask_storeu_epi64((void*)(ri + j), store_mask, _mm512_xor_si512(rj, acc));
+  }
+}
+
+#endif
+
+inline bool gf2_mul_kernel_supported(gf2_mul_kernel k) {
+  switch (k) {
+    case gf2_mul_kernel_portable: return true;
+    case gf2_mul_kernel_pclmul: return gf2_cpu().pclmul;
+    case gf2_mul_kernel_vpclmul: return gf2_cpu().avx512_vpclmul;
+  }
+  return false;
+}
+
+inline gf2_mul_kernel gf2_best_mul_kernel() {
+  if (gf2_mul_kernel_supported(gf2_mul_kernel_vpclmul))
+    return gf2_mul_kernel_vpclmul;
+  if (gf2_mul_kernel_supported(gf2_mul_kernel_pclmul))
+    return gf2_mul_kernel_pclmul;
+  return gf2_mul_kernel_portable;
+}
+
+inline gf2_mul_kernel& gf2_active_mul_kernel() {
+  static gf2_mul_kernel k = gf2_best_mul_kernel();
+  return k;
+}
+
+inline void gf2_set_mul_kernel(gf2_mul_kernel k) {
+  if (!gf2_mul_kernel_supported(k))
+    throw std::runtime_error("gf2_set_mul_kernel: kernel is not supported on this cpu!");
+  gf2_active_mul_kernel() = k;
+}
+
+// quadratic product with the active kernel
+inline void gf2_words_mul_basecase(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+#if defined(GF2_X86_INTRINSICS)
+  switch (gf2_active_mul_kernel()) {
+    case gf2_mul_kernel_vpclmul:
+      // the inner loop runs over b, so b should be the long operand
+      if (na > nb) {
+        std::swap(a, b);
+        std::swap(na, nb);
+      }
+      if (nb >= 8) {
+        gf2_words_mul_vpclmul(r, a, na, b, nb);
+        return;
+      }
+      gf2_words_mul_pclmul(r, a, na, b, nb);
+      return;
+    case gf2_mul_kernel_pclmul:
+      gf2_words_mul_pclmul(r, a, na, b, nb);
+      return;
+    default:
+      break;
+  }
+#endif
+  gf2_words_mul_schoolbook(r, a, na, b, nb);
+}
+
+/*
+Build time defaults, measured with gf2_calibrate_mul_thresholds. The faster the basecase, the later Karatsuba pays off.
+Define GF2_KARATSUBA_THRESHOLD, GF2_TOOM3_THRESHOLD and GF2_FFT_THRESHOLD to override them.
+*/
+inline gf2_mul_thresholds gf2_default_mul_thresholds() {
+  gf2_mul_thresholds t;
+  switch (gf2_best_mul_kernel()) {
+    case gf2_mul_kernel_vpclmul: t.karatsuba = 96; t.toom3 = 256; t.fft = 16384; break;
+    case gf2_mul_kernel_pclmul: t.karatsuba = 24; t.toom3 = 384; t.fft = 8192; break;
+    default: t.karatsuba = 8; t.toom3 = 64; t.fft = 8192; break;
+  }
+#ifdef GF2_KARATSUBA_THRESHOLD
+  t.karatsuba = GF2_KARATSUBA_THRESHOLD;
+#endif
+#ifdef GF2_TOOM3_THRESHOLD
+  t.toom3 = GF2_TOOM3_THRESHOLD;
+#endif
+#ifdef GF2_FFT_THRESHOLD
+  t.fft = GF2_FFT_THRESHOLD;
+#endif
+  return t;
+}
+
+inline gf2_mul_thresholds& gf2_active_mul_thresholds() {
+  static gf2_mul_thresholds t = gf2_default_mul_thresholds();
+  return t;
+}
+
+inline void gf2_words_mul(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb);
+
+// c /= (1+x), c must be divisible by 1+x: the quotient is the prefix xor of the bits of c
+inline void gf2_words_divide_by_x_plus_1(uint64_t* c, size_t n) {
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t x = c[i];
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    x ^= carry;
+    carry = 0 - (x >> 63);
+    c[i] = x;
+  }
+}
+
+// c /= x, c must be divisible by x
+inline void gf2_words_divide_by_x(uint64_t* c, size_t n) {
+  for (size_t i = 0; i + 1 < n; ++i)
+    c[i] = (c[i] >> 1) | (c[i+1] << 63);
+  if (n)
+    c[n-1] >>= 1;
+}
+
+inline void gf2_words_xor(uint64_t* r, const uint64_t* a, size_t n) {
+  for (size_t i = 0; i < n; ++i)
+    r[i] ^= a[i];
+}
+
+/*
+a = a0 + a1*y with y = x^(64m), m = ceil(na/2):
+a*b = a0*b0 + ((a0+a1)*(b0+b1) + a0*b0 + a1*b1)*y + a1*b1*y^2
+Needs na >= nb > m.
+*/
+inline void gf2_words_mul_karatsuba(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+  const size_t m = (na+1)/2;
+  const size_t na1 = na-m;
+  const size_t nb1 = nb-m;
+  gf2_words_mul(r, a, m, b, m);
+  gf2_words_mul(r+2*m, a+m, na1, b+m, nb1);
+  std::vector<uint64_t> buf(4*m);
+  uint64_t* sa = buf.data();
+  uint64_t* sb = sa+m;
+  uint64_t* z1 = sb+m;
+  std::copy(a, a+m, sa);
+  std::copy(b, b+m, sb);
+  gf2_words_xor(sa, a+m, na1);
+  gf2_words_xor(sb, b+m, nb1);
+  gf2_words_mul(z1, sa, m, sb, m);
+  gf2_words_xor(z1, r, 2*m);
+  gf2_words_xor(z1, r+2*m, na1+nb1);
+  gf2_words_xor(r+m, z1, 2*m);
+}
+
+/*
+Toom-3 over GF(2)[x] with evaluation points 0, 1, x, x+1 and infinity, see Bodrato,
+"Towards optimal Toom-Cook multiplication for univariate and multivariate polynomials in characteristic 2 and 0".
+a = a0 + a1*y + a2*y^2 with y = x^(64k), k = ceil(na/3), and c = a*b = c0 + c1*y + ... + c4*y^4. Then
+  c0 = W0, c4 = Winf
+  c3 = (W1 + Wx + Wx1 + c0) / (x^2+x)
+  c1 + c2*x = (Wx + c0 + c3*x^3 + c4*x^4) / x
+  c1 + c2 = W1 + c0 + c3 + c4
+so that c2 and c1 follow with one more exact division by x+1.
+Needs na >= nb > 2k.
+*/
+inline void gf2_words_mul_toom3(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+  const size_t k = (na+2)/3;
+  const size_t na2 = na-2*k;
+  const size_t nb2 = nb-2*k;
+  const size_t n = na+nb;
+  const size_t w = 2*k+2;
+  std::vector<uint64_t> buf(6*(k+1) + 3*w, 0);
+  uint64_t* e1a = buf.data();
+  uint64_t* e1b = e1a+(k+1);
+  uint64_t* exa = e1b+(k+1);
+  uint64_t* exb = exa+(k+1);
+  uint64_t* ex1a = exb+(k+1);
+  uint64_t* ex1b = ex1a+(k+1);
+  uint64_t* w1 = ex1b+(k+1);
+  uint64_t* wx = w1+w;
+  uint64_t* wx1 = wx+w;
+
+  // evaluate at 1, x and x+1
+  std::copy(a, a+k, e1a);
+  gf2_words_xor(e1a, a+k, k);
+  gf2_words_xor(e1a, a+2*k, na2);
+  std::copy(b, b+k, e1b);
+  gf2_words_xor(e1b, b+k, k);
+  gf2_words_xor(e1b, b+2*k, nb2);
+  std::copy(a, a+k, exa);
+  gf2_words_xor_shifted(exa, a+k, k, 1);
+  gf2_words_xor_shifted(exa, a+2*k, na2, 2);
+  std::copy(b, b+k, exb);
+  gf2_words_xor_shifted(exb, b+k, k, 1);
+  gf2_words_xor_shifted(exb, b+2*k, nb2, 2);
+  std::copy(exa, exa+k+1, ex1a);
+  gf2_words_xor(ex1a, a+k, k);
+  gf2_words_xor(ex1a, a+2*k, na2);
+  std::copy(exb, exb+k+1, ex1b);
+  gf2_words_xor(ex1b, b+k, k);
+  gf2_words_xor(ex1b, b+2*k, nb2);
+
+  uint64_t* c0 = r;
+  uint64_t* c4 = r+4*k;
+  const size_t n4 = na2+nb2;
+  gf2_words_mul(c0, a, k, b, k);
+  gf2_words_mul(c4, a+2*k, na2, b+2*k, nb2);
+  gf2_words_mul(w1, e1a, k, e1b, k);
+  gf2_words_mul(wx, exa, k+1, exb, k+1);
+  gf2_words_mul(wx1, ex1a, k+1, ex1b, k+1);
+
+  // wx1 = c3*(x^2+x)/x/(x+1) = c3
+  gf2_words_xor(wx1, wx, w);
+  gf2_words_xor(wx1, w1, 2*k);
+  gf2_words_xor(wx1, c0, 2*k);
+  gf2_words_divide_by_x(wx1, w);
+  gf2_words_divide_by_x_plus_1(wx1, w);
+  uint64_t* c3 = wx1;
+  // wx = c1 + c2*x
+  gf2_words_xor(wx, c0, 2*k);
+  gf2_words_xor_shifted(wx, c3, 2*k, 3);
+  gf2_words_xor_shifted(wx, c4, n4, 4);
+  gf2_words_divide_by_x(wx, w);
+  // w1 = c1 + c2
+  gf2_words_xor(w1, c0, 2*k);
+  gf2_words_xor(w1, c3, 2*k);
+  gf2_words_xor(w1, c4, n4);
+  // wx = c2, w1 = c1
+  gf2_words_xor(wx, w1, 2*k);
+  gf2_words_divide_by_x_plus_1(wx, w);
+  gf2_words_xor(w1, wx, 2*k);
+
+  std::fill(r+2*k, r+4*k, 0);
+  gf2_words_xor(r+k, w1, 2*k);
+  gf2_words_xor(r+2*k, wx, 2*k);
+  gf2_words_xor(r+3*k, c3, std::min(2*k, n-3*k));
+}
+
+inline void gf2_words_mul(uint64_t* r, const uint64_t* a, size_t na, const uint64_t* b, size_t nb) {
+  if (na < nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  const gf2_mul_thresholds& t = gf2_active_mul_thresholds();
+  if (nb < t.karatsuba || nb < 2) {
+    gf2_words_mul_basecase(r, a, na, b, nb);
+    return;
+  }
+  if (nb >= t.fft) {
+    const gf2_mul_kernel k = gf2_active_mul_kernel();
+    gf2_words_mul_fft(r, a, na, b, nb, k != gf2_mul_kernel_portable, k == gf2_mul_kernel_vpclmul);
+    return;
+  }
+  if (nb <= (na+1)/2) {
+    // unbalanced: cut a in pieces of nb words
+    std::fill(r, r+na+nb, 0);
+    std::vector<uint64_t> tmp(2*nb);
+    for (size_t offset = 0; offset < na; offset += nb) {
+      const size_t len = std::min(nb, na-offset);
+      gf2_words_mul(tmp.data(), a+offset, len, b, nb);
+      gf2_words_xor(r+offset, tmp.data(), len+nb);
+    }
+    return;
+  }
+  if (nb >= t.toom3 && nb > 2*((na+2)/3)) {
+    gf2_words_mul_toom3(r, a, na, b, nb);
+    return;
+  }
+  gf2_words_mul_karatsuba(r, a, na, b, nb);
+}
+
+/*
+Measures the crossover points on this machine and makes them the active thresholds.
+Meant to be called once at startup, it takes up to a second because of the fft crossover.
+*/
+inline gf2_mul_thresholds gf2_calibrate_mul_thresholds() {
+  typedef void (*kernel_fn)(uint64_t*, const uint64_t*, size_t, const uint64_t*, size_t);
+  gf2_mul_thresholds& active = gf2_active_mul_thresholds();
+  const size_t never = (size_t)-1;
+  uint64_t state = 0x9e3779b97f4a7c15ULL;
+  std::vector<uint64_t> a(2048), b(2048), r(4096);
+  for (size_t i = 0; i < a.size(); ++i) {
+    state = state*6364136223846793005ULL + 1442695040888963407ULL;
+    a[i] = state;
+    state = state*6364136223846793005ULL + 1442695040888963407ULL;
+    b[i] = state;
+  }
+  auto time_of = [&](kernel_fn f, size_t n) {
+    double best = 1e30;
+    for (int rep = 0; rep < 5; ++rep) {
+      auto tic = std::chrono::steady_clock::now();
+      int iterations = 0;
+      do {
+        f(r.data(), a.data(), n, b.data(), n);
+        ++iterations;
+      } while (std::chrono::steady_clock::now() - tic < std::chrono::microseconds(200));
+      double t = std::chrono::duration<double>(std::chrono::steady_clock::now() - tic).count()/iterations;
+      best = std::min(best, t);
+    }
+    return best;
+  };
+
+  // one level of karatsuba on top of the basecase against the basecase itself
+  active.karatsuba = never;
+  active.toom3 = never;
+  active.fft = never;
+  size_t karatsuba = 256;
+  const size_t karatsuba_sizes[] = {4, 6, 8, 12, 16, 24, 32, 48, 64, 96, 128, 192, 256};
+  for (size_t n : karatsuba_sizes) {
+    if (time_of(&gf2_words_mul_karatsuba, n) < time_of(&gf2_words_mul_basecase, n)) {
+      karatsuba = n;
+      break;
+    }
+  }
+  active.karatsuba = karatsuba;
+
+  // one level of toom-3 against one level of karatsuba, both recursing with karatsuba below
+  size_t toom3 = 2048;
+  const size_t toom3_sizes[] = {32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048};
+  for (size_t n : toom3_sizes) {
+    if (n < karatsuba)
+      continue;
+    if (time_of(&gf2_words_mul_toom3, n) < time_of(&gf2_words_mul_karatsuba, n)) {
+      toom3 = n;
+      break;
+    }
+  }
+  active.toom3 = toom3;
+
+  // the fft against the recursive product, on sizes where a single product takes milliseconds
+  size_t fft = never;
+  std::vector<uint64_t> big_a, big_b, big_r;
+  for (size_t n = 2048; n <= 65536 && fft == never; n *= 2) {
+    big_a.resize(n);
+    big_b.resize(n);
+    big_r.resize(2*n);
+    for (size_t i = 0; i < n; ++i) {
+      state = state*6364136223846793005ULL + 1442695040888963407ULL;
+      big_a[i] = state;
+      big_b[i] = state ^ (state >> 29);
+    }
+    const gf2_mul_kernel k = gf2_active_mul_kernel();
+    auto tic = std::chrono::steady_clock::now();
+    gf2_words_mul_fft(big_r.data(), big_a.data(), n, big_b.data(), n, k != gf2_mul_kernel_portable, k == gf2_mul_kernel_vpclmul);
+    auto tac = std::chrono::steady_clock::now();
+    gf2_words_mul(big_r.data(), big_a.data(), n, big_b.data(), n);
+    auto toc = std::chrono::steady_clock::now();
+    if (tac - tic < toc - tac)
+      fft = n;
+  }
+  active.fft = fft;
+  return active;
+}
+
+#endif
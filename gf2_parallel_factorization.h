@@ -0,0 +1,136 @@
+#ifndef GF2_PARALLEL_FACTORIZATION_H
+#define GF2_PARALLEL_FACTORIZATION_H
+
+#include "gf2_polynomial.h"
+#include "gf2_thread_pool.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+/*
+Factorization of a single polynomial on a gf2_thread_pool, for latency on huge inputs where
+batch parallelism does not help. The split tree of the equal degree factorization is processed level by level:
+in every round all unsplit factors are tried at the same time, each with several random trials when there are
+fewer factors than workers. A trial computes the trace map modulo its own factor only and splits it with one gcd.
+Worker w seeds its own random engine with seed + w, the factors themselves do not depend on the seed.
+*/
+
+/*
+Splits every group (g, d) of a distinct degree factorization into its irreducible factors of degree d.
+Each factor comes back with the tag of its group.
+*/
+inline std::vector<std::pair<gf2_polynomial, uint64_t>> equal_degree_split_parallel(const std::vector<std::pair<gf2_polynomial, uint64_t>>& groups, const std::vector<uint64_t>& tags, gf2_thread_pool& pool, uint64_t seed) {
+  // the modulus and trace tables are built once per factor, a factor whose trials all failed keeps them
+  struct node {
+    gf2_polynomial u;
+    uint64_t d;
+    uint64_t tag;
+    gf2_modulus modulus;
+    gf2_trace_context trace;
+    bool ready;
+  };
+  GF2_STAT_TIMER(gf2_stage_equal_degree);
+  std::vector<std::pair<gf2_polynomial, uint64_t>> factors;
+  std::vector<node> pending;
+  for (size_t i = 0; i < groups.size(); ++i) {
+    const auto& g = groups[i];
+    if (is_zero(g.first) || degree(g.first) == 0)
+      continue;
+    if (degree(g.first) <= g.second)
+      factors.push_back(std::make_pair(g.first, tags[i]));
+    else
+      pending.push_back(node{g.first, g.second, tags[i], gf2_modulus(), gf2_trace_context(), false});
+  }
+  std::vector<char> seeded(pool.size(), 0);
+  const auto unit = make_xn(0);
+  std::vector<size_t> fresh;
+  while (!pending.empty()) {
+    // the moduli and trace tables of the new factors are built in parallel, then shared by their trials
+    fresh.clear();
+    for (size_t i = 0; i < pending.size(); ++i) {
+      if (!pending[i].ready)
+        fresh.push_back(i);
+    }
+    pool.parallel_for(fresh.size(), [&](size_t k, unsigned) {
+      node& n = pending[fresh[k]];
+      n.modulus = make_gf2_modulus(n.u);
+      n.trace = make_gf2_trace_context(n.d, n.modulus);
+      n.ready = true;
+    });
+    const size_t trials = std::max<size_t>(1, pool.size()/pending.size());
+    std::vector<std::pair<gf2_polynomial, gf2_polynomial>> splits(pending.size()*trials);
+    pool.parallel_for(splits.size(), [&](size_t t, unsigned worker) {
+      if (!seeded[worker]) {
+        gf2_random_engine().seed(seed + worker);
+        seeded[worker] = 1;
+      }
+      const node& n = pending[t/trials];
+      const gf2_polynomial& u = n.u;
+      GF2_STAT(gf2_stat_edf_trial, degree(u));
+      // g = h + h^2 + h^4 + ... + h^(2^(d-1)) mod u
+      auto h = make_random_gf2_polynomial(degree(u)-1);
+      auto g = trace_map(h, n.trace, n.modulus);
+      if (is_zero(g)) {
+        GF2_STAT(gf2_stat_edf_failed_split, degree(u));
+        return;
+      }
+      auto s = gcd(std::move(g), u);
+      if (s != unit && s != u)
+        splits[t] = std::make_pair(u/s, std::move(s));
+      else
+        GF2_STAT(gf2_stat_edf_failed_split, degree(u));
+    });
+    std::vector<node> next;
+    for (size_t i = 0; i < pending.size(); ++i) {
+      size_t t = i*trials;
+      while (t < (i+1)*trials && is_zero(splits[t].first))
+        ++t;
+      if (t == (i+1)*trials) {
+        next.push_back(std::move(pending[i]));
+        continue;
+      }
+      for (auto* part : {&splits[t].first, &splits[t].second}) {
+        if (degree(*part) == pending[i].d)
+          factors.push_back(std::make_pair(std::move(*part), pending[i].tag));
+        else
+          next.push_back(node{std::move(*part), pending[i].d, pending[i].tag, gf2_modulus(), gf2_trace_context(), false});
+      }
+    }
+    pending.swap(next);
+  }
+  std::sort(factors.begin(), factors.end(), [](const std::pair<gf2_polynomial, uint64_t>& a, const std::pair<gf2_polynomial, uint64_t>& b) {
+    return less_by_degree(a.first, b.first);
+  });
+  return factors;
+}
+
+// f must be square free with all its irreducible factors of degree d, the factors are sorted by degree
+inline std::vector<gf2_polynomial> equal_degree_factorization_parallel(const gf2_polynomial& f, uint64_t d, gf2_thread_pool& pool, uint64_t seed = 0) {
+  std::vector<std::pair<gf2_polynomial, uint64_t>> groups;
+  groups.push_back(std::make_pair(f, d));
+  std::vector<gf2_polynomial> factors;
+  for (auto& p : equal_degree_split_parallel(groups, std::vector<uint64_t>(1, 0), pool, seed))
+    factors.push_back(std::move(p.first));
+  return factors;
+}
+
+/*
+Complete factorization like factor(f) with Cantor-Zassenhaus, where the equal degree splitting of all
+distinct degree groups of all square free parts shares one parallel split tree.
+*/
+inline gf2_factorization factor_parallel(const gf2_polynomial& f, gf2_thread_pool& pool, uint64_t seed = 0) {
+  if (is_zero(f))
+    throw std::runtime_error("factor: zero polynomial!");
+  std::vector<std::pair<gf2_polynomial, uint64_t>> groups;
+  std::vector<uint64_t> multiplicity;
+  for (const auto& part : square_free_decomposition(f)) {
+    for (auto& g : distinct_degree_factorization(part.first)) {
+      groups.push_back(std::move(g));
+      multiplicity.push_back(part.second);
+    }
+  }
+  return equal_degree_split_parallel(groups, multiplicity, pool, seed);
+}
+
+#endif
@@ -0,0 +1,334 @@
+#ifndef GF2_POLY_FIXED_H
+#define GF2_POLY_FIXED_H
+
+#include "gf2_polynomial.h"
+
+#include <stdint.h>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+/*
+Polynomials with at most N coefficients (degree < N) in inline storage, for the small sizes of GHASH, CRCs and
+binary field arithmetic where the heap allocated gf2_polynomial is pure overhead.
+All arithmetic is constexpr (C++14) and allocation free. Products are exact: a*b of N and M coefficients has
+N+M-1 of them, and a remainder has the width of its divisor, so nothing is truncated silently.
+The layout is the one of gf2_polynomial: coefficient i is bit (i&63) of words[i>>6], bits from N on are zero.
+*/
+template <size_t N>
+struct gf2_poly_fixed {
+  static_assert(N > 0, "gf2_poly_fixed needs at least one coefficient");
+  static constexpr size_t word_count = (N+63)/64;
+  uint64_t words[word_count] = {};
+};
+
+// at run time the word products use pclmulqdq when the cpu has it, during constant evaluation the portable loop
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define GF2_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+#endif
+#if !defined(GF2_CONSTANT_EVALUATED) && defined(_MSC_VER) && _MSC_VER >= 1925
+#define GF2_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+// x must be nonzero
+constexpr int gf2_fixed_top_bit(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+  return 63 - __builtin_clzll(x);
+#else
+  int r = 0;
+  for (int s = 32; s > 0; s >>= 1) {
+    if (x >> s) {
+      x >>= s;
+      r += s;
+    }
+  }
+  return r;
+#endif
+}
+
+constexpr uint64_t gf2_fixed_clmul64(uint64_t a, uint64_t b, uint64_t& hi) {
+#if defined(GF2_CONSTANT_EVALUATED)
+  if (!GF2_CONSTANT_EVALUATED())
+    return gf2_clmul64(a, b, hi);
+#endif
+  uint64_t lo = 0;
+  hi = 0;
+  for (int i = 0; i < 64; ++i) {
+    if ((a >> i) & 1) {
+      lo ^= b << i;
+      if (i)
+        hi ^= b >> (64 - i);
+    }
+  }
+  return lo;
+}
+
+// r ^= b * x^shift, bits that fall beyond r are dropped
+template <size_t N, size_t M>
+constexpr void gf2_fixed_xor_shifted(gf2_poly_fixed<N>& r, const gf2_poly_fixed<M>& b, uint64_t shift) {
+  const size_t w = (size_t)(shift >> 6);
+  const unsigned s = (unsigned)(shift & 63);
+  for (size_t i = 0; i < gf2_poly_fixed<M>::word_count && i + w < gf2_poly_fixed<N>::word_count; ++i) {
+    r.words[i + w] ^= b.words[i] << s;
+    if (s && i + w + 1 < gf2_poly_fixed<N>::word_count)
+      r.words[i + w + 1] ^= b.words[i] >> (64 - s);
+  }
+}
+
+template <size_t N>
+constexpr bool is_zero(const gf2_poly_fixed<N>& p) {
+  for (size_t i = 0; i < gf2_poly_fixed<N>::word_count; ++i) {
+    if (p.words[i])
+      return false;
+  }
+  return true;
+}
+
+// the degree of the zero polynomial is 0, as for gf2_polynomial
+template <size_t N>
+constexpr uint64_t degree(const gf2_poly_fixed<N>& p) {
+  for (size_t i = gf2_poly_fixed<N>::word_count; i-- > 0;) {
+    if (p.words[i])
+      return (uint64_t)i*64 + gf2_fixed_top_bit(p.words[i]);
+  }
+  return 0;
+}
+
+template <size_t N>
+constexpr int coefficient(const gf2_poly_fixed<N>& p, uint64_t i) {
+  return i < N ? (int)((p.words[i>>6] >> (i&63)) & 1) : 0;
+}
+
+template <size_t N>
+constexpr bool operator == (const gf2_poly_fixed<N>& a, const gf2_poly_fixed<N>& b) {
+  for (size_t i = 0; i < gf2_poly_fixed<N>::word_count; ++i) {
+    if (a.words[i] != b.words[i])
+      return false;
+  }
+  return true;
+}
+
+template <size_t N>
+constexpr bool operator != (const gf2_poly_fixed<N>& a, const gf2_poly_fixed<N>& b) {
+  return !(a == b);
+}
+
+template <size_t N>
+constexpr gf2_poly_fixed<N> operator + (const gf2_poly_fixed<N>& a, const gf2_poly_fixed<N>& b) {
+  gf2_poly_fixed<N> r;
+  for (size_t i = 0; i < gf2_poly_fixed<N>::word_count; ++i)
+    r.words[i] = a.words[i] ^ b.words[i];
+  return r;
+}
+
+template <size_t N>
+constexpr gf2_poly_fixed<N> operator - (const gf2_poly_fixed<N>& a, const gf2_poly_fixed<N>& b) {
+  return a + b;
+}
+
+// the polynomial with the coefficients of the bits of low
+template <size_t N>
+constexpr gf2_poly_fixed<N> make_gf2_poly_fixed(uint64_t low) {
+  if (N < 64 && (low >> (N & 63)))
+    throw std::runtime_error("make_gf2_poly_fixed: polynomial does not fit!");
+  gf2_poly_fixed<N> r;
+  r.words[0] = low;
+  return r;
+}
+
+template <size_t N>
+constexpr gf2_poly_fixed<N> make_gf2_poly_fixed_xn(uint64_t n) {
+  if (n >= N)
+    throw std::runtime_error("make_gf2_poly_fixed_xn: polynomial does not fit!");
+  gf2_poly_fixed<N> r;
+  r.words[n>>6] = (uint64_t)1 << (n&63);
+  return r;
+}
+
+// conversion between widths, p must fit
+template <size_t N, size_t M>
+constexpr gf2_poly_fixed<N> make_gf2_poly_fixed(const gf2_poly_fixed<M>& p) {
+  if (!is_zero(p) && degree(p) >= N)
+    throw std::runtime_error("make_gf2_poly_fixed: polynomial does not fit!");
+  gf2_poly_fixed<N> r;
+  for (size_t i = 0; i < gf2_poly_fixed<N>::word_count && i < gf2_poly_fixed<M>::word_count; ++i)
+    r.words[i] = p.words[i];
+  return r;
+}
+
+template <size_t N>
+gf2_poly_fixed<N> make_gf2_poly_fixed(const gf2_polynomial& p) {
+  if (!is_zero(p) && degree(p) >= N)
+    throw std::runtime_error("make_gf2_poly_fixed: polynomial does not fit!");
+  gf2_poly_fixed<N> r;
+  for (size_t i = 0; i < p.words.size(); ++i)
+    r.words[i] = p.words[i];
+  return r;
+}
+
+template <size_t N>
+gf2_polynomial to_gf2_polynomial(const gf2_poly_fixed<N>& p) {
+  return make_gf2_polynomial_from_words(std::vector<uint64_t>(p.words, p.words + gf2_poly_fixed<N>::word_count));
+}
+
+template <size_t N>
+constexpr gf2_poly_fixed<N> hex_to_gf2_poly_fixed(const char* hexadecimal_number) {
+  size_t len = 0;
+  while (hexadecimal_number[len])
+    ++len;
+  gf2_poly_fixed<N> r;
+  for (size_t k = 0; k < len; ++k) {
+    const char ch = hexadecimal_number[len-1-k];
+    uint64_t i = 0;
+    if (ch >= '0' && ch <= '9')
+      i = (uint64_t)(ch-'0');
+    else if (ch >= 'A' && ch <= 'F')
+      i = (uint64_t)(ch-'A'+10);
+    else if (ch >= 'a' && ch <= 'f')
+      i = (uint64_t)(ch-'a'+10);
+    else
+      throw std::runtime_error("hex_to_gf2_poly_fixed: input string is not a hexadecimal number!");
+    if (i == 0)
+      continue;
+    if (4*k + gf2_fixed_top_bit(i) >= N)
+      throw std::runtime_error("hex_to_gf2_poly_fixed: polynomial does not fit!");
+    r.words[k>>4] |= i << (4*(k&15));
+  }
+  return r;
+}
+
+template <size_t N>
+std::string gf2_poly_fixed_to_hex(const gf2_poly_fixed<N>& p) {
+  return gf2_polynomial_to_hex(to_gf2_polynomial(p));
+}
+
+// the exact product, with N+M-1 coefficients
+template <size_t N, size_t M>
+constexpr gf2_poly_fixed<N+M-1> operator * (const gf2_poly_fixed<N>& a, const gf2_poly_fixed<M>& b) {
+  gf2_poly_fixed<N+M-1> r;
+#if defined(GF2_CONSTANT_EVALUATED)
+  if (!GF2_CONSTANT_EVALUATED()) {
+    uint64_t t[gf2_poly_fixed<N>::word_count + gf2_poly_fixed<M>::word_count] = {};
+    gf2_words_mul_basecase(t, a.words, gf2_poly_fixed<N>::word_count, b.words, gf2_poly_fixed<M>::word_count);
+    for (size_t i = 0; i < gf2_poly_fixed<N+M-1>::word_count; ++i)
+      r.words[i] = t[i];
+    return r;
+  }
+#endif
+  for (size_t i = 0; i < gf2_poly_fixed<N>::word_count; ++i) {
+    if (a.words[i] == 0)
+      continue;
+    for (size_t j = 0; j < gf2_poly_fixed<M>::word_count; ++j) {
+      uint64_t hi = 0;
+      const uint64_t lo = gf2_fixed_clmul64(a.words[i], b.words[j], hi);
+      r.words[i+j] ^= lo;
+      if (i+j+1 < gf2_poly_fixed<N+M-1>::word_count)
+        r.words[i+j+1] ^= hi;
+    }
+  }
+  return r;
+}
+
+// r = a mod b in place, one quotient bit at a time, with the quotient bits set in q if it is not null
+template <size_t N, size_t M, size_t Q>
+constexpr void gf2_fixed_reduce(gf2_poly_fixed<N>& r, const gf2_poly_fixed<M>& b, gf2_poly_fixed<Q>* q) {
+  if (is_zero(b))
+    throw std::runtime_error("euclidean_division: division by zero!");
+  const uint64_t d = degree(b);
+  uint64_t i = degree(r);
+  while (!is_zero(r) && i >= d) {
+    gf2_fixed_xor_shifted(r, b, i - d);
+    if (q)
+      q->words[(i-d)>>6] |= (uint64_t)1 << ((i-d)&63);
+    i = degree(r);
+  }
+}
+
+template <size_t N, size_t M>
+constexpr gf2_poly_fixed<M> operator % (const gf2_poly_fixed<N>& a, const gf2_poly_fixed<M>& b) {
+  gf2_poly_fixed<N> r = a;
+  gf2_fixed_reduce(r, b, (gf2_poly_fixed<N>*)nullptr);
+  return make_gf2_poly_fixed<M>(r);
+}
+
+template <size_t N, size_t M>
+constexpr gf2_poly_fixed<N> operator / (const gf2_poly_fixed<N>& a, const gf2_poly_fixed<M>& b) {
+  gf2_poly_fixed<N> r = a;
+  gf2_poly_fixed<N> q;
+  gf2_fixed_reduce(r, b, &q);
+  return q;
+}
+
+// a*b mod f
+template <size_t N>
+constexpr gf2_poly_fixed<N> mulmod(const gf2_poly_fixed<N>& a, const gf2_poly_fixed<N>& b, const gf2_poly_fixed<N>& f) {
+  return (a*b) % f;
+}
+
+// p / x^n, dropping the remainder
+template <size_t N>
+constexpr gf2_poly_fixed<N> div_xn(const gf2_poly_fixed<N>& p, uint64_t n) {
+  gf2_poly_fixed<N> r;
+  const size_t w = (size_t)(n >> 6);
+  const unsigned s = (unsigned)(n & 63);
+  for (size_t i = 0; i + w < gf2_poly_fixed<N>::word_count; ++i) {
+    r.words[i] = p.words[i + w] >> s;
+    if (s && i + w + 1 < gf2_poly_fixed<N>::word_count)
+      r.words[i] |= p.words[i + w + 1] << (64 - s);
+  }
+  return r;
+}
+
+/*
+Precomputed data for repeated reductions modulo a fixed f with N coefficients, deg(f) = n:
+the Barrett constant mu = x^(2n) / f turns the reduction of a product of two reduced polynomials into two products,
+q = (a / x^n) * mu / x^n and a mod f = a - q*f, instead of a shift-xor per quotient bit.
+*/
+template <size_t N>
+struct gf2_modulus_fixed {
+  gf2_poly_fixed<N> f;
+  uint64_t n = 0;
+  gf2_poly_fixed<N> mu;
+};
+
+template <size_t N>
+constexpr gf2_modulus_fixed<N> make_gf2_modulus_fixed(const gf2_poly_fixed<N>& f) {
+  if (is_zero(f))
+    throw std::runtime_error("make_gf2_modulus_fixed: modulus is zero!");
+  gf2_modulus_fixed<N> m;
+  m.f = f;
+  m.n = degree(f);
+  gf2_poly_fixed<2*N-1> x2n;
+  x2n.words[(2*m.n)>>6] = (uint64_t)1 << ((2*m.n)&63);
+  m.mu = make_gf2_poly_fixed<N>(x2n / f);
+  return m;
+}
+
+// a mod f for deg(a) < 2n, so for the product of two reduced polynomials
+template <size_t N>
+constexpr gf2_poly_fixed<N> reduce(const gf2_poly_fixed<2*N-1>& a, const gf2_modulus_fixed<N>& m) {
+  const gf2_poly_fixed<N> q = make_gf2_poly_fixed<N>(div_xn(make_gf2_poly_fixed<N>(div_xn(a, m.n))*m.mu, m.n));
+  const gf2_poly_fixed<2*N-1> r = a + q*m.f;
+  return make_gf2_poly_fixed<N>(r);
+}
+
+// a*b mod f for reduced a and b
+template <size_t N>
+constexpr gf2_poly_fixed<N> mulmod(const gf2_poly_fixed<N>& a, const gf2_poly_fixed<N>& b, const gf2_modulus_fixed<N>& m) {
+  return reduce(a*b, m);
+}
+
+template <size_t N>
+constexpr gf2_poly_fixed<N> gcd(gf2_poly_fixed<N> a, gf2_poly_fixed<N> b) {
+  while (!is_zero(b)) {
+    gf2_fixed_reduce(a, b, (gf2_poly_fixed<N>*)nullptr);
+    const gf2_poly_fixed<N> t = a;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+
+#endif
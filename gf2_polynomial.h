@@ -1,15 +1,51 @@
 #ifndef GF2_POLYNOMIAL_H
 #define GF2_POLYNOMIAL_H
 
+#include "gf2_words.h"
+#include "gf2_multiplication.h"
+#include "gf2_matrix.h"
+#include "gf2_stats.h"
+
+#include <algorithm>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
 #include <vector>
 #include <cmath>
+#include <cstdlib>
+#include <random>
 
+/*
+Coefficients are packed 64 per word: coefficient i is bit (i&63) of words[i>>6].
+The words vector never ends in a zero word, so the zero polynomial has no words.
+deg caches the degree, and is 0 for the zero polynomial.
+*/
 struct gf2_polynomial {
-  std::vector<uint8_t> coefficients;
+  std::vector<uint64_t> words;
+  uint64_t deg = 0;
 };
 
-std::vector<uint8_t> simplify_gf2_coefficients(const std::vector<uint8_t>& coeff) {
+inline void normalize(gf2_polynomial& p) {
+  while (!p.words.empty() && p.words.back() == 0)
+    p.words.pop_back();
+  if (p.words.empty())
+    p.deg = 0;
+  else
+    p.deg = (uint64_t)(p.words.size()-1)*64 + 63 - gf2_clz64(p.words.back());
+}
+
+inline bool is_zero(const gf2_polynomial& p) {
+  return p.words.empty();
+}
+
+inline int coefficient(const gf2_polynomial& p, uint64_t i) {
+  if ((i>>6) >= p.words.size())
+    return 0;
+  return (int)((p.words[i>>6] >> (i&63)) & 1);
+}
+
+inline std::vector<uint8_t> simplify_gf2_coefficients(const std::vector<uint8_t>& coeff) {
   std::vector<uint8_t> c(coeff);
   while (!c.empty() && ((c.back()&1)==0))
     c.pop_back();
@@ -19,73 +55,112 @@ std::vector<uint8_t> simplify_gf2_coefficients(const std::vector<uint8_t>& coeff
 }
 
 inline gf2_polynomial simplify(const gf2_polynomial& g) {
-  gf2_polynomial ret;
-  ret.coefficients = simplify_gf2_coefficients(g.coefficients);
+  gf2_polynomial ret(g);
+  normalize(ret);
   return ret;
 }
 
+// conversion from one coefficient per byte, only the lowest bit of each byte is used
 inline gf2_polynomial make_gf2_polynomial(const std::vector<uint8_t>& coef) {
   gf2_polynomial g;
-  g.coefficients = simplify_gf2_coefficients(coef);
+  g.words.resize((coef.size()+63)/64, 0);
+  for (size_t i = 0; i < coef.size(); ++i) {
+    if (coef[i]&1)
+      g.words[i>>6] |= (uint64_t)1 << (i&63);
+  }
+  normalize(g);
   return g;
 }
 
-inline gf2_polynomial hex_to_gf2_polynomial(std::string hexadecimal_number) {
-  std::vector<uint8_t> coeff;
-  coeff.reserve(4*hexadecimal_number.length());
-  while (!hexadecimal_number.empty()) {
-    char ch = hexadecimal_number.back();
-    int i = 0;
-    if (ch >= '0' && ch <= '9')
-      i = (int)(ch-'0');
-    else if (ch >= 'A' && ch <= 'F')
-      i = (int)(ch-'A'+10);
-    else if (ch >= 'a' && ch <= 'f')
-      i = (int)(ch-'a'+10);
-    else throw std::runtime_error("make_gf2_polynomial: input string is not a hexadecimal number!");
-    coeff.push_back(i&1?1:0);
-    coeff.push_back(i&2?1:0);
-    coeff.push_back(i&4?1:0);
-    coeff.push_back(i&8?1:0);
-    hexadecimal_number.pop_back();
-  }
-  return make_gf2_polynomial(coeff);
+inline gf2_polynomial make_gf2_polynomial_from_words(std::vector<uint64_t> words) {
+  gf2_polynomial g;
+  g.words.swap(words);
+  normalize(g);
+  return g;
+}
+
+// conversion back to one coefficient per byte
+inline std::vector<uint8_t> gf2_polynomial_to_coefficients(const gf2_polynomial& g) {
+  std::vector<uint8_t> coef;
+  if (is_zero(g))
+    return coef;
+  coef.resize(g.deg+1);
+  for (uint64_t i = 0; i <= g.deg; ++i)
+    coef[i] = (uint8_t)((g.words[i>>6] >> (i&63)) & 1);
+  return coef;
+}
+
+// the value of every hexadecimal digit, 16 for the other characters
+inline const uint8_t* gf2_hex_digit_values() {
+  struct table {
+    uint8_t v[256];
+    table() {
+      for (int c = 0; c < 256; ++c)
+        v[c] = 16;
+      for (int c = 0; c < 10; ++c)
+        v['0'+c] = (uint8_t)c;
+      for (int c = 0; c < 6; ++c)
+        v['a'+c] = v['A'+c] = (uint8_t)(10+c);
+    }
+  };
+  static const table t;
+  return t.v;
+}
+
+// the last 16 digits make up the lowest word, and so on, one check for invalid characters per word
+inline gf2_polynomial hex_to_gf2_polynomial(const std::string& hexadecimal_number) {
+  const uint8_t* values = gf2_hex_digit_values();
+  const char* s = hexadecimal_number.data();
+  const size_t len = hexadecimal_number.length();
+  gf2_polynomial g;
+  g.words.resize((len+15)/16);
+  for (size_t k = 0; k < g.words.size(); ++k) {
+    const size_t end = len - 16*k;
+    const size_t begin = end > 16 ? end-16 : 0;
+    uint64_t w = 0;
+    uint8_t invalid = 0;
+    for (size_t j = begin; j < end; ++j) {
+      const uint8_t v = values[(unsigned char)s[j]];
+      invalid |= v;
+      w = (w << 4) | (v & 15);
+    }
+    if (invalid & 16)
+      throw std::runtime_error("make_gf2_polynomial: input string is not a hexadecimal number!");
+    g.words[k] = w;
+  }
+  normalize(g);
+  return g;
 }
 
 inline std::string gf2_polynomial_to_hex(const gf2_polynomial& g) {
-  std::string s;
-  const size_t sz = g.coefficients.size();
-  s.reserve(sz/4+1);
-  for (size_t i = 0; i < sz; i+=4) {
-    int i0 = g.coefficients[i];
-    int i1 = i+1 < sz ? g.coefficients[i+1]:0;
-    int i2 = i+2 < sz ? g.coefficients[i+2]:0;
-    int i3 = i+3 < sz ? g.coefficients[i+3]:0;
-    int h = i0+2*i1+4*i2+8*i3;
-    if (h<10)
-      s.push_back(h+'0');
-    else
-      s.push_back(h-10+'a');
-  }
-  std::reverse(s.begin(), s.end());
+  static const char digits[] = "0123456789abcdef";
+  if (is_zero(g))
+    return std::string();
+  const uint64_t nibbles = g.deg/4+1;
+  std::string s((size_t)nibbles, '0');
+  for (uint64_t k = 0; k < nibbles; ++k)
+    s[(size_t)(nibbles-1-k)] = digits[(g.words[k>>4] >> (4*(k&15))) & 15];
   return s;
 }
 
 inline gf2_polynomial make_xn(uint64_t n) {
   gf2_polynomial g;
-  for (size_t i = 0; i < n; ++i)
-    g.coefficients.push_back(0);
-  g.coefficients.push_back(1);
+  g.words.resize(n/64+1, 0);
+  g.words.back() = (uint64_t)1 << (n&63);
+  g.deg = n;
   return g;
 }
 
-std::ostream& operator<<(std::ostream& s, const gf2_polynomial& p) {
+inline std::ostream& operator<<(std::ostream& s, const gf2_polynomial& p) {
   bool first = true;
-  if (p.coefficients.empty())
+  if (is_zero(p))
     s << "0";
-  int count = p.coefficients.size()-1;
-  for (auto rit = p.coefficients.rbegin(); rit != p.coefficients.rend(); ++rit,--count) {
-    if(*rit & 1) {
+  for (size_t w = p.words.size(); w-- > 0;) {
+    uint64_t word = p.words[w];
+    while (word) {
+      int bit = 63 - gf2_clz64(word);
+      word ^= (uint64_t)1 << bit;
+      uint64_t count = (uint64_t)w*64 + bit;
       if (!first)
         s << " + ";
       if (count)
@@ -99,28 +174,11 @@ std::ostream& operator<<(std::ostream& s, const gf2_polynomial& p) {
 }
 
 inline uint64_t degree(const gf2_polynomial& p) {
-  if (p.coefficients.empty())
-    return 0;
-  uint64_t deg = p.coefficients.size()-1;
-  while (deg && ((p.coefficients[deg]&1)==0))
-    --deg;
-  return deg;
+  return p.deg;
 }
 
 inline bool operator == (const gf2_polynomial& a, const gf2_polynomial& b) {
-  uint64_t d1 = degree(a);
-  uint64_t d2 = degree(b);
-  if (d1 != d2)
-    return false;
-  if (a.coefficients.empty())
-    return b.coefficients.empty() || (b.coefficients.front()&1)==0;
-  if (b.coefficients.empty())
-    return (a.coefficients.front()&1)==0;
-  for (uint64_t i = 0; i <= d1; ++i) {
-    if ((a.coefficients[i]&1) != (b.coefficients[i]&1))
-      return false;
-  }
-  return true;
+  return a.deg == b.deg && a.words == b.words;
 }
 
 inline bool operator != (const gf2_polynomial& a, const gf2_polynomial& b) {
@@ -128,17 +186,15 @@ inline bool operator != (const gf2_polynomial& a, const gf2_polynomial& b) {
 }
 
 inline gf2_polynomial operator + (const gf2_polynomial& a, const gf2_polynomial& b) {
-  if (a.coefficients.size()>=b.coefficients.size()) {
-    auto coef = a.coefficients;
-    for (size_t i=0; i < b.coefficients.size(); ++i)
-      coef[i] += b.coefficients[i];
-    return make_gf2_polynomial(coef);
-  } else {
-    auto coef = b.coefficients;
-    for (size_t i=0; i < a.coefficients.size(); ++i)
-      coef[i] += a.coefficients[i];
-    return make_gf2_polynomial(coef);
-  }
+  const gf2_polynomial& big = a.words.size() >= b.words.size() ? a : b;
+  const gf2_polynomial& small = a.words.size() >= b.words.size() ? b : a;
+  gf2_polynomial r;
+  GF2_STAT_GROW(r.words, big.words.size());
+  r.words = big.words;
+  for (size_t i = 0; i < small.words.size(); ++i)
+    r.words[i] ^= small.words[i];
+  normalize(r);
+  return r;
 }
 
 inline gf2_polynomial operator - (const gf2_polynomial& a, const gf2_polynomial& b) {
@@ -157,168 +213,1099 @@ inline gf2_polynomial operator - (const gf2_polynomial& a, const gf2_polynomial&
         b <<= 1;
     }
     return r;
+    This loop is applied to 64 coefficients at a time, with pclmulqdq / vpclmulqdq when the cpu has them,
+    see gf2_multiplication.h.
 */
 inline gf2_polynomial operator * (const gf2_polynomial& a, const gf2_polynomial& b) {
-  uint64_t a_index = 0;
-  std::vector<uint8_t> coeff;
-  coeff.reserve(a.coefficients.size()*b.coefficients.size());
-  while (a_index < a.coefficients.size()) {
-    if (a.coefficients[a_index]&1) {
-      coeff.resize(b.coefficients.size()+a_index);
-      for (size_t i = 0; i < b.coefficients.size(); ++i)
-        coeff[i+a_index] ^= b.coefficients[i];
-    }
-    ++a_index;
+  gf2_polynomial r;
+  if (is_zero(a) || is_zero(b))
+    return r;
+  GF2_STAT(gf2_stat_mul, std::max(a.deg, b.deg));
+  GF2_STAT_GROW(r.words, a.words.size()+b.words.size());
+  r.words.resize(a.words.size()+b.words.size());
+  gf2_words_mul(r.words.data(), a.words.data(), a.words.size(), b.words.data(), b.words.size());
+  normalize(r);
+  return r;
+}
+
+/*
+The compound operators and the *_into functions below write into the words of an existing polynomial,
+which are only reallocated when they are too small, so loops that keep their temporaries outside stop allocating.
+*/
+inline gf2_polynomial& operator += (gf2_polynomial& a, const gf2_polynomial& b) {
+  if (a.words.size() < b.words.size()) {
+    GF2_STAT_GROW(a.words, b.words.size());
+    a.words.resize(b.words.size(), 0);
   }
-  return make_gf2_polynomial(coeff);
+  gf2_words_xor(a.words.data(), b.words.data(), b.words.size());
+  normalize(a);
+  return a;
 }
 
-inline gf2_polynomial derivative(const gf2_polynomial& p) {
-  std::vector<uint8_t> coeff;
-  coeff.reserve(p.coefficients.size());
-  for (size_t i = 1; i < p.coefficients.size(); ++i) {
-    if ((i&1)==0 || (p.coefficients[i]&1)==0)
-      coeff.push_back(0);
-    else
-      coeff.push_back(1);
+inline gf2_polynomial& operator -= (gf2_polynomial& a, const gf2_polynomial& b) {
+  return a += b;
+}
+
+// the product kernels must not write into their inputs, so in place products go through this buffer of the calling thread
+inline std::vector<uint64_t>& gf2_scratch_words() {
+  static thread_local std::vector<uint64_t> words;
+  return words;
+}
+
+// the product is formed in the scratch buffer, which then trades places with the words of a
+inline gf2_polynomial& operator *= (gf2_polynomial& a, const gf2_polynomial& b) {
+  if (is_zero(a) || is_zero(b)) {
+    a.words.clear();
+    a.deg = 0;
+    return a;
+  }
+  GF2_STAT(gf2_stat_mul, std::max(a.deg, b.deg));
+  std::vector<uint64_t>& scratch = gf2_scratch_words();
+  GF2_STAT_GROW(scratch, a.words.size()+b.words.size());
+  scratch.resize(a.words.size()+b.words.size());
+  gf2_words_mul(scratch.data(), a.words.data(), a.words.size(), b.words.data(), b.words.size());
+  a.words.swap(scratch);
+  normalize(a);
+  return a;
+}
+
+// dst = a*b, dst may be a or b
+inline void mul_into(gf2_polynomial& dst, const gf2_polynomial& a, const gf2_polynomial& b) {
+  if (&dst == &a) {
+    dst *= b;
+    return;
   }
-  return make_gf2_polynomial(coeff);
+  if (&dst == &b) {
+    dst *= a;
+    return;
+  }
+  if (is_zero(a) || is_zero(b)) {
+    dst.words.clear();
+    dst.deg = 0;
+    return;
+  }
+  GF2_STAT(gf2_stat_mul, std::max(a.deg, b.deg));
+  GF2_STAT_GROW(dst.words, a.words.size()+b.words.size());
+  dst.words.resize(a.words.size()+b.words.size());
+  gf2_words_mul(dst.words.data(), a.words.data(), a.words.size(), b.words.data(), b.words.size());
+  normalize(dst);
+}
+
+// only odd powers survive: coefficient i of p' is coefficient i+1 of p for even i
+inline gf2_polynomial derivative(const gf2_polynomial& p) {
+  gf2_polynomial r;
+  r.words.resize(p.words.size());
+  for (size_t i = 0; i < p.words.size(); ++i)
+    r.words[i] = (p.words[i] >> 1) & 0x5555555555555555ULL;
+  normalize(r);
+  return r;
 }
 
 inline void minus_b_times_xn(gf2_polynomial& r, const gf2_polynomial& b, uint64_t n)
   {
-  if (r.coefficients.size() < b.coefficients.size()+n)
-    r.coefficients.resize(b.coefficients.size()+n, 0);
-  for (uint64_t i = 0; i < b.coefficients.size(); ++i) {
-    r.coefficients[i+n] += b.coefficients[i];
-    r.coefficients[i+n] &= 1;
+  if (is_zero(b))
+    return;
+  const uint64_t top = (b.deg+n)/64+1;
+  if (r.words.size() < top)
+    r.words.resize(top, 0);
+  gf2_words_xor_shifted(r.words.data(), b.words.data(), b.words.size(), n);
+  normalize(r);
+  }
+
+/*
+Reduces r modulo b in place, one quotient bit at a time but a full word of r per xor.
+If q is not null the quotient bits are set in q->words, which must be large enough.
+*/
+inline void reduce_in_place(gf2_polynomial& r, const gf2_polynomial& b, gf2_polynomial* q = nullptr) {
+  if (is_zero(b))
+    throw std::runtime_error("euclidean_division: division by zero!");
+  const uint64_t d = b.deg;
+  const size_t nb = b.words.size();
+  uint64_t deg_r = r.deg;
+  size_t top = r.words.size();
+  while (top > 0 && deg_r >= d) {
+    uint64_t n = deg_r - d;
+    if (q)
+      q->words[n>>6] |= (uint64_t)1 << (n&63);
+    gf2_words_xor_shifted(r.words.data(), b.words.data(), nb, n);
+    while (top > 0 && r.words[top-1] == 0)
+      --top;
+    if (top > 0)
+      deg_r = (uint64_t)(top-1)*64 + 63 - gf2_clz64(r.words[top-1]);
+  }
+  r.words.resize(top);
+  normalize(r);
+}
+
+/*
+Low weight divisors b = x^n + sum x^e with at most 5 terms and every e <= n/2, such as the trinomials and pentanomials
+of binary fields and CRC generators. Sets terms to the exponents e from the largest down and returns their number,
+or returns -1 for all other b. Below degree 8 a fold hardly clears any bits, so those b count as dense.
+*/
+inline int gf2_sparse_terms(const gf2_polynomial& b, uint64_t terms[4]) {
+  if (is_zero(b) || b.deg < 8)
+    return -1;
+  int count = -1;
+  for (size_t i = b.words.size(); i-- > 0;) {
+    uint64_t w = b.words[i];
+    while (w) {
+      const int bit = 63 - gf2_clz64(w);
+      w ^= (uint64_t)1 << bit;
+      const uint64_t e = (uint64_t)i*64 + bit;
+      if (count == 4 || (count >= 0 && 2*e > b.deg))
+        return -1;
+      if (count >= 0)
+        terms[count] = e;
+      ++count;
+    }
+  }
+  return count;
+}
+
+// r = r mod (x^n + sum x^terms[j]) for the terms of gf2_sparse_terms, if q is not null the quotient bits are set in q->words
+inline void reduce_sparse_in_place(gf2_polynomial& r, uint64_t n, const uint64_t* terms, int count, gf2_polynomial* q = nullptr) {
+  if (is_zero(r) || r.deg < n)
+    return;
+  gf2_words_reduce_sparse(r.words.data(), r.words.size(), n, terms, count, q ? q->words.data() : nullptr);
+  normalize(r);
+}
+
+// p * x^n
+inline gf2_polynomial mul_xn(const gf2_polynomial& p, uint64_t n) {
+  gf2_polynomial r;
+  if (is_zero(p))
+    return r;
+  r.words.resize((p.deg+n)/64+1, 0);
+  gf2_words_xor_shifted(r.words.data(), p.words.data(), p.words.size(), n);
+  r.deg = p.deg+n;
+  return r;
+}
+
+// p / x^n, dropping the remainder
+inline gf2_polynomial div_xn(const gf2_polynomial& p, uint64_t n) {
+  gf2_polynomial r;
+  if (is_zero(p) || p.deg < n)
+    return r;
+  const size_t w = n >> 6;
+  const unsigned s = (unsigned)(n & 63);
+  r.words.resize(p.words.size()-w);
+  for (size_t i = 0; i < r.words.size(); ++i) {
+    uint64_t lo = p.words[i+w] >> s;
+    uint64_t hi = (s && i+w+1 < p.words.size()) ? p.words[i+w+1] << (64-s) : 0;
+    r.words[i] = lo | hi;
+  }
+  normalize(r);
+  return r;
+}
+
+// p mod x^n
+inline gf2_polynomial mod_xn(const gf2_polynomial& p, uint64_t n) {
+  if (is_zero(p) || p.deg < n)
+    return p;
+  gf2_polynomial r;
+  r.words.assign(p.words.begin(), p.words.begin() + (n+63)/64);
+  if (n & 63)
+    r.words.back() &= ((uint64_t)1 << (n&63)) - 1;
+  normalize(r);
+  return r;
+}
+
+// x^n * p(1/x), p must have degree at most n
+inline gf2_polynomial reversal(const gf2_polynomial& p, uint64_t n) {
+  gf2_polynomial r;
+  if (is_zero(p))
+    return r;
+  const size_t w = n/64+1;
+  r.words.resize(w, 0);
+  for (size_t i = 0; i < p.words.size(); ++i)
+    r.words[w-1-i] = gf2_bit_reverse64(p.words[i]);
+  // the word reversal mirrors around 64w-1, move it back to n
+  const unsigned s = (unsigned)(64*w-1-n);
+  if (s) {
+    for (size_t i = 0; i+1 < w; ++i)
+      r.words[i] = (r.words[i] >> s) | (r.words[i+1] << (64-s));
+    r.words[w-1] >>= s;
   }
-  while (!r.coefficients.empty() && ((r.coefficients.back()&1)==0))
-    r.coefficients.pop_back();
+  normalize(r);
+  return r;
+}
+
+/*
+Inverse of the power series g modulo x^k by Newton iteration, g(0) must be 1.
+In characteristic 2 the step h <- h*(2 - g*h) becomes h <- g*h^2 mod x^(2*precision).
+*/
+inline gf2_polynomial newton_inverse(const gf2_polynomial& g, uint64_t k) {
+  if (coefficient(g, 0) == 0)
+    throw std::runtime_error("newton_inverse: constant term is zero!");
+  gf2_polynomial h = make_xn(0);
+  uint64_t precision = 1;
+  while (precision < k) {
+    precision = std::min(2*precision, k);
+    h = mod_xn(mod_xn(g, precision) * mod_xn(h*h, precision), precision);
   }
+  return h;
+}
+
+/*
+Divisors and quotients of at least this many words are divided with a Newton inverse,
+smaller ones with the shift-xor loop of reduce_in_place.
+*/
+inline size_t& gf2_newton_division_threshold() {
+  static size_t words = 16;
+  return words;
+}
+
+/*
+Division with a precomputed inv = 1/reversal(b) mod x^k where k > deg(a)-deg(b):
+the reversed quotient is reversal(a)*inv mod x^(deg(a)-deg(b)+1), so the division costs two multiplications.
+*/
+inline void divrem_with_inverse(const gf2_polynomial& a, const gf2_polynomial& b, const gf2_polynomial& inv, gf2_polynomial* q, gf2_polynomial& r) {
+  if (is_zero(a) || a.deg < b.deg) {
+    if (q)
+      *q = gf2_polynomial();
+    r = a;
+    return;
+  }
+  const uint64_t m = a.deg - b.deg;
+  gf2_polynomial rev_q = mod_xn(mod_xn(reversal(a, a.deg), m+1) * mod_xn(inv, m+1), m+1);
+  gf2_polynomial quotient = reversal(rev_q, m);
+  r = mod_xn(mod_xn(quotient, b.deg) * mod_xn(b, b.deg) + a, b.deg);
+  if (q)
+    *q = std::move(quotient);
+}
+
+inline bool use_newton_division(const gf2_polynomial& a, const gf2_polynomial& b) {
+  const uint64_t bits = 64*(uint64_t)gf2_newton_division_threshold();
+  return !is_zero(b) && !is_zero(a) && a.deg >= b.deg && b.deg >= bits && a.deg - b.deg >= bits;
+}
+
+inline void divrem_newton(const gf2_polynomial& a, const gf2_polynomial& b, gf2_polynomial* q, gf2_polynomial& r) {
+  const uint64_t m = a.deg - b.deg;
+  divrem_with_inverse(a, b, newton_inverse(reversal(b, b.deg), m+1), q, r);
+}
+
+/*
+q = a/b and r = a mod b, written into the words of q and r. r may be a, which then is divided in place,
+q may be a if r is not, neither may be b.
+*/
+inline void divrem_into(gf2_polynomial& q, gf2_polynomial& r, const gf2_polynomial& a, const gf2_polynomial& b) {
+  if (is_zero(b))
+    throw std::runtime_error("euclidean_division: division by zero!");
+  uint64_t terms[4];
+  const int count = is_zero(a) || a.deg < b.deg ? -1 : gf2_sparse_terms(b, terms);
+  GF2_STAT(gf2_stat_divrem, a.deg);
+  if (count < 0 && use_newton_division(a, b)) {
+    divrem_newton(a, b, &q, r);
+    return;
+  }
+  if (&r != &a) {
+    GF2_STAT_GROW(r.words, a.words.size());
+    r.words.assign(a.words.begin(), a.words.end());
+    r.deg = a.deg;
+  }
+  const size_t quotient_words = is_zero(r) || r.deg < b.deg ? 0 : (r.deg-b.deg)/64+1;
+  GF2_STAT_GROW(q.words, quotient_words);
+  q.words.assign(quotient_words, 0);
+  if (count >= 0)
+    reduce_sparse_in_place(r, b.deg, terms, count, &q);
+  else
+    reduce_in_place(r, b, &q);
+  normalize(q);
+}
 
 /*
 The Euclidean division provides two polynomials q(x), the quotient and r(x), the remainder such that
 a(x)=q0(x)b(x)+r0(x) and deg⁡(r0(x)) < deg⁡(b(x))
 */
 inline std::pair<gf2_polynomial, gf2_polynomial> euclidean_division(const gf2_polynomial& a, const gf2_polynomial& b) {
-  gf2_polynomial r(a);
-  gf2_polynomial q;
-  auto d = degree(b);
-  auto deg_a = degree(a);
-  uint64_t qsize = deg_a>d?deg_a-d+1:1;
-  q.coefficients.resize(qsize,0);
-  uint64_t deg_r = degree(r);
-  while(!r.coefficients.empty() && deg_r >= d) {
-    uint64_t deg_b = degree(b);
-    uint64_t n = deg_r - deg_b;
-    q.coefficients[n] = 1;
-    minus_b_times_xn(r, b, n);
-    deg_r = degree(r);
-  }
-  return std::make_pair(simplify(q), simplify(r));
+  gf2_polynomial q, r;
+  divrem_into(q, r, a, b);
+  return std::make_pair(std::move(q), std::move(r));
 }
 
 inline gf2_polynomial operator / (const gf2_polynomial& a, const gf2_polynomial& b) {
   return euclidean_division(a,b).first;
 }
 
+// a = a mod b, by folding for low weight b, with a Newton inverse when both the divisor and the quotient are large
+inline void remainder_in_place(gf2_polynomial& a, const gf2_polynomial& b) {
+  GF2_STAT(gf2_stat_divrem, a.deg);
+  uint64_t terms[4];
+  const int count = is_zero(a) || a.deg < b.deg ? -1 : gf2_sparse_terms(b, terms);
+  if (count >= 0) {
+    reduce_sparse_in_place(a, b.deg, terms, count);
+  } else if (use_newton_division(a, b)) {
+    gf2_polynomial r;
+    divrem_newton(a, b, nullptr, r);
+    a = std::move(r);
+  } else {
+    reduce_in_place(a, b);
+  }
+}
+
+inline gf2_polynomial& operator %= (gf2_polynomial& a, const gf2_polynomial& b) {
+  remainder_in_place(a, b);
+  return a;
+}
+
 inline gf2_polynomial operator % (const gf2_polynomial& a, const gf2_polynomial& b) {
-  return euclidean_division(a,b).second;
+  gf2_polynomial r;
+  GF2_STAT_GROW(r.words, a.words.size());
+  r = a;
+  remainder_in_place(r, b);
+  return r;
 }
 
-inline gf2_polynomial gcd(gf2_polynomial a, gf2_polynomial b) {
+// classical Euclidean algorithm
+inline gf2_polynomial gcd_euclidean(gf2_polynomial a, gf2_polynomial b) {
+  GF2_STAT(gf2_stat_gcd, std::max(a.deg, b.deg));
   if (degree(a)<degree(b))
-    std::swap(a.coefficients, b.coefficients);
-  gf2_polynomial r = a % b;
-  while(!r.coefficients.empty()) {
-    std::swap(a.coefficients, b.coefficients);
-    std::swap(r.coefficients, b.coefficients);
+    std::swap(a, b);
+  if (is_zero(b))
+    return a;
+  remainder_in_place(a, b);
+  while(!is_zero(a)) {
+    std::swap(a, b);
     //a = b;
     //b = r;
-    r = a % b;
+    remainder_in_place(a, b);
   }
   return b;
 }
 
+// degree with -1 for the zero polynomial
+inline int64_t signed_degree(const gf2_polynomial& p) {
+  return is_zero(p) ? -1 : (int64_t)p.deg;
+}
+
+// 2x2 matrix acting on a pair of polynomials (a, b) as a column vector
+struct gf2_polynomial_matrix2 {
+  gf2_polynomial m00, m01, m10, m11;
+};
+
+inline gf2_polynomial_matrix2 make_identity_matrix2() {
+  gf2_polynomial_matrix2 M;
+  M.m00 = make_xn(0);
+  M.m11 = make_xn(0);
+  return M;
+}
+
+inline gf2_polynomial_matrix2 operator * (const gf2_polynomial_matrix2& A, const gf2_polynomial_matrix2& B) {
+  gf2_polynomial_matrix2 C;
+  C.m00 = A.m00*B.m00 + A.m01*B.m10;
+  C.m01 = A.m00*B.m01 + A.m01*B.m11;
+  C.m10 = A.m10*B.m00 + A.m11*B.m10;
+  C.m11 = A.m10*B.m01 + A.m11*B.m11;
+  return C;
+}
+
+// M = [[0, 1], [1, q]] * M, the matrix of one Euclidean step (a, b) -> (b, a - q*b)
+inline void apply_quotient(gf2_polynomial_matrix2& M, const gf2_polynomial& q, gf2_polynomial& scratch) {
+  mul_into(scratch, q, M.m10);
+  M.m00 += scratch;
+  mul_into(scratch, q, M.m11);
+  M.m01 += scratch;
+  std::swap(M.m00, M.m10);
+  std::swap(M.m01, M.m11);
+}
+
+inline void apply_quotient(gf2_polynomial_matrix2& M, const gf2_polynomial& q) {
+  gf2_polynomial scratch;
+  apply_quotient(M, q, scratch);
+}
+
+// one Euclidean step (a, b) -> (b, a mod b), M is updated accordingly, q and scratch are reused across steps
+inline void euclidean_step(gf2_polynomial& a, gf2_polynomial& b, gf2_polynomial_matrix2& M, gf2_polynomial& q, gf2_polynomial& scratch) {
+  divrem_into(q, a, a, b);
+  std::swap(a, b);
+  apply_quotient(M, q, scratch);
+}
+
+inline void euclidean_step(gf2_polynomial& a, gf2_polynomial& b, gf2_polynomial_matrix2& M) {
+  gf2_polynomial q, scratch;
+  euclidean_step(a, b, M, q, scratch);
+}
+
+// from this degree on gcd and extended_gcd reduce the operands with half gcd steps
+inline uint64_t& gf2_half_gcd_threshold() {
+  static uint64_t deg = 12288;
+  return deg;
+}
+
+// below this degree half_gcd_in_place does Euclidean steps instead of recursing
+inline uint64_t& gf2_half_gcd_recursion_threshold() {
+  static uint64_t deg = 768;
+  return deg;
+}
+
+/*
+Half gcd (Knuth-Schoenhage), in the formulation of Thull and Yap.
+For deg(a) = n > deg(b) the pair (a, b) is replaced by the consecutive remainders (a', b') of the
+Euclidean remainder sequence with deg(a') > n/2 >= deg(b'), and M is set such that (a', b') = M*(a, b).
+A reduction of the leading coefficients (a0, b0) that stops above deg(a0)/2 is also a reduction of (a, b),
+so both halves of the quotient sequence are computed recursively on the top coefficients only,
+which makes the cost O(M(n) log n).
+*/
+inline void half_gcd_in_place(gf2_polynomial& a, gf2_polynomial& b, gf2_polynomial_matrix2& M) {
+  GF2_STAT(gf2_stat_half_gcd, a.deg);
+  const int64_t n = signed_degree(a);
+  const int64_t m = n/2 + 1;
+  M = make_identity_matrix2();
+  if (signed_degree(b) < m)
+    return;
+  gf2_polynomial q, scratch;
+  if ((uint64_t)n < gf2_half_gcd_recursion_threshold() || n < 8) {
+    while (signed_degree(b) >= m)
+      euclidean_step(a, b, M, q, scratch);
+    return;
+  }
+  // (a, b) = (a0, b0)*x^m + (a1, b1), the recursion on (a0, b0) gives the first half of the quotients
+  gf2_polynomial a0 = div_xn(a, m), b0 = div_xn(b, m);
+  gf2_polynomial a1 = mod_xn(a, m), b1 = mod_xn(b, m);
+  half_gcd_in_place(a0, b0, M);
+  // (a, b) = (a0, b0)*x^m + M*(a1, b1)
+  a = mul_xn(a0, m);
+  mul_into(scratch, M.m00, a1);
+  a += scratch;
+  mul_into(scratch, M.m01, b1);
+  a += scratch;
+  b = mul_xn(b0, m);
+  mul_into(scratch, M.m10, a1);
+  b += scratch;
+  mul_into(scratch, M.m11, b1);
+  b += scratch;
+  if (signed_degree(b) < m)
+    return;
+  euclidean_step(a, b, M, q, scratch);
+  if (signed_degree(b) < m)
+    return;
+  // with l = deg(a) a second recursion on the top 2(l-m+1) coefficients stops right above m
+  const int64_t k = 2*(m-1) - signed_degree(a);
+  if (k < 0) {
+    while (signed_degree(b) >= m)
+      euclidean_step(a, b, M, q, scratch);
+    return;
+  }
+  gf2_polynomial c0 = div_xn(a, k), d0 = div_xn(b, k);
+  gf2_polynomial c1 = mod_xn(a, k), d1 = mod_xn(b, k);
+  gf2_polynomial_matrix2 S;
+  half_gcd_in_place(c0, d0, S);
+  a = mul_xn(c0, k);
+  mul_into(scratch, S.m00, c1);
+  a += scratch;
+  mul_into(scratch, S.m01, d1);
+  a += scratch;
+  b = mul_xn(d0, k);
+  mul_into(scratch, S.m10, c1);
+  b += scratch;
+  mul_into(scratch, S.m11, d1);
+  b += scratch;
+  M = S*M;
+}
+
+/*
+Greatest common divisor: half gcd steps while the operands are large, each of which halves the degree,
+then the classical Euclidean algorithm. gcd_in_place leaves the gcd in a and uses the words of b as scratch.
+*/
+inline void gcd_in_place(gf2_polynomial& a, gf2_polynomial& b) {
+  GF2_STAT(gf2_stat_gcd, std::max(a.deg, b.deg));
+  if (degree(a)<degree(b))
+    std::swap(a, b);
+  while (!is_zero(b) && b.deg >= gf2_half_gcd_threshold()) {
+    if (a.deg > b.deg) {
+      gf2_polynomial_matrix2 M;
+      half_gcd_in_place(a, b, M);
+      if (is_zero(b))
+        break;
+    }
+    remainder_in_place(a, b);
+    std::swap(a, b);
+  }
+  while (!is_zero(b)) {
+    remainder_in_place(a, b);
+    std::swap(a, b);
+  }
+}
+
+inline gf2_polynomial gcd(gf2_polynomial a, gf2_polynomial b) {
+  gcd_in_place(a, b);
+  return a;
+}
+
+/*
+Extended gcd: returns g = gcd(a, b) and sets s and t with s*a + t*b = g.
+The cofactors are the ones of the Euclidean algorithm, so deg(s) < deg(b) and deg(t) < deg(a) unless g is a or b.
+*/
+inline gf2_polynomial extended_gcd(const gf2_polynomial& a, const gf2_polynomial& b, gf2_polynomial& s, gf2_polynomial& t) {
+  gf2_polynomial g(a), h(b), q, scratch;
+  gf2_polynomial_matrix2 M = make_identity_matrix2();
+  if (signed_degree(g) < signed_degree(h)) {
+    std::swap(g, h);
+    std::swap(M.m00, M.m01);
+    std::swap(M.m10, M.m11);
+  }
+  while (!is_zero(h)) {
+    if (g.deg > h.deg && h.deg >= gf2_half_gcd_threshold()) {
+      gf2_polynomial_matrix2 R;
+      half_gcd_in_place(g, h, R);
+      M = R*M;
+      if (is_zero(h))
+        break;
+    }
+    euclidean_step(g, h, M, q, scratch);
+  }
+  s = std::move(M.m00);
+  t = std::move(M.m01);
+  return g;
+}
+
+// the inverse of a modulo f, throws if gcd(a, f) is not 1
+inline gf2_polynomial modular_inverse(const gf2_polynomial& a, const gf2_polynomial& f) {
+  if (is_zero(f))
+    throw std::runtime_error("modular_inverse: modulus is zero!");
+  gf2_polynomial s, t;
+  gf2_polynomial g = extended_gcd(a % f, f, s, t);
+  if (g != make_xn(0))
+    throw std::runtime_error("modular_inverse: polynomial is not invertible!");
+  remainder_in_place(s, f);
+  return s;
+}
+
+// a^2: over GF(2) the cross terms cancel, so the coefficients just move to the even positions
+inline gf2_polynomial square(const gf2_polynomial& a) {
+  gf2_polynomial r;
+  if (is_zero(a))
+    return r;
+  GF2_STAT(gf2_stat_square, a.deg);
+  GF2_STAT_GROW(r.words, 2*a.words.size());
+  r.words.resize(2*a.words.size());
+  gf2_words_square(r.words.data(), a.words.data(), a.words.size());
+  normalize(r);
+  return r;
+}
+
+// a^p by square and multiply, 1 for p <= 0
 inline gf2_polynomial power(const gf2_polynomial& a, int p) {
   gf2_polynomial result = make_gf2_polynomial({1});
-  for (int i = 1; i <= p; ++i)
-    result = result * a;
+  if (p <= 0)
+    return result;
+  gf2_polynomial base(a);
+  while (true) {
+    if (p & 1)
+      result = result * base;
+    p >>= 1;
+    if (p == 0)
+      break;
+    base = square(base);
+  }
   return result;
 }
 
+// keeps the even coefficients, which is the square root if a is a square
 inline gf2_polynomial sqrt(const gf2_polynomial& a) {
   gf2_polynomial result;
-  for (int i = 0; i < a.coefficients.size(); ++i)
-    if (i%2==0) {
-      result.coefficients.push_back(a.coefficients[i]);
-    }
+  result.words.resize((a.words.size()+1)/2);
+  gf2_words_sqrt(result.words.data(), a.words.data(), a.words.size());
+  normalize(result);
   return result;
 }
 
-inline gf2_polynomial make_random_gf2_polynomial(uint64_t n) {
+// the random engine of the calling thread, seed it with gf2_random_engine().seed(s) for reproducible results
+inline std::mt19937_64& gf2_random_engine() {
+  static thread_local std::mt19937_64 engine;
+  return engine;
+}
+
+// random polynomial of degree at most n, drawn from rng
+template <class Engine>
+inline gf2_polynomial make_random_gf2_polynomial(uint64_t n, Engine& rng) {
+  std::uniform_int_distribution<uint64_t> word;
   gf2_polynomial p;
-  for (uint64_t i = 0; i <= n; ++i)
-    p.coefficients.push_back(rand()&1);
-  return simplify(p);
+  p.words.resize(n/64+1);
+  for (auto& w : p.words)
+    w = word(rng);
+  if ((n&63) != 63)
+    p.words.back() &= ((uint64_t)1 << ((n&63)+1)) - 1;
+  normalize(p);
+  return p;
 }
 
-//source: https://en.wikipedia.org/wiki/Factorization_of_polynomials_over_finite_fields
-inline std::vector<gf2_polynomial> square_free_factorization(const gf2_polynomial& f) {
-  std::vector<gf2_polynomial> R;
-  R.push_back(make_gf2_polynomial({1}));
-  
+inline gf2_polynomial make_random_gf2_polynomial(uint64_t n) {
+  return make_random_gf2_polynomial(n, gf2_random_engine());
+}
+
+/*
+Precomputed data for repeated arithmetic modulo a fixed f:
+  - inverse = 1/reversal(f) mod x^(n-1), enough to reduce any product of two reduced polynomials with divrem_with_inverse
+  - sparse is set for the low weight f of gf2_sparse_terms (trinomials, pentanomials), whose exponents below n
+    are listed in sparse_terms, such f are reduced by folding the excess bits back with a few shifted xors instead
+  - frobenius[i] = x^(2^i) mod f, filled on demand by frobenius_power
+*/
+struct gf2_modulus {
+  gf2_polynomial f;
+  uint64_t n = 0;
+  gf2_polynomial inverse;
+  bool sparse = false;
+  std::vector<uint64_t> sparse_terms;
+  std::vector<gf2_polynomial> frobenius;
+};
+
+inline gf2_modulus make_gf2_modulus(const gf2_polynomial& f) {
+  if (is_zero(f))
+    throw std::runtime_error("make_gf2_modulus: modulus is zero!");
+  gf2_modulus m;
+  m.f = f;
+  m.n = f.deg;
+  uint64_t terms[4];
+  const int count = gf2_sparse_terms(f, terms);
+  m.sparse = count >= 0;
+  if (m.sparse)
+    m.sparse_terms.assign(terms, terms + count);
+  else if (m.n >= 2)
+    m.inverse = newton_inverse(reversal(f, m.n), m.n-1);
+  return m;
+}
+
+// a = a mod f for the low weight f of gf2_sparse_terms
+inline void reduce_sparse(gf2_polynomial& a, const gf2_modulus& m) {
+  reduce_sparse_in_place(a, m.n, m.sparse_terms.data(), (int)m.sparse_terms.size());
+}
+
+// a = a mod f
+inline void reduce(gf2_polynomial& a, const gf2_modulus& m) {
+  if (is_zero(a) || a.deg < m.n)
+    return;
+  if (m.n == 0) {
+    a = gf2_polynomial();
+    return;
+  }
+  if (m.sparse) {
+    reduce_sparse(a, m);
+    return;
+  }
+  // with the inverse already at hand the division costs two products, which beats the shift-xor loop from two words on
+  if (a.deg - m.n + 1 <= m.n - 1 && m.n >= 128) {
+    gf2_polynomial r;
+    divrem_with_inverse(a, m.f, m.inverse, nullptr, r);
+    a = std::move(r);
+    return;
+  }
+  remainder_in_place(a, m.f);
+}
+
+// dst = a*b mod f, dst may be a or b
+inline void mulmod_into(gf2_polynomial& dst, const gf2_polynomial& a, const gf2_polynomial& b, const gf2_modulus& m) {
+  GF2_STAT(gf2_stat_mulmod, m.n);
+  mul_into(dst, a, b);
+  reduce(dst, m);
+}
+
+// dst = a^2 mod f, dst may be a
+inline void sqrmod_into(gf2_polynomial& dst, const gf2_polynomial& a, const gf2_modulus& m) {
+  GF2_STAT(gf2_stat_sqrmod, m.n);
+  if (is_zero(a)) {
+    dst.words.clear();
+    dst.deg = 0;
+    return;
+  }
+  std::vector<uint64_t>& out = &dst == &a ? gf2_scratch_words() : dst.words;
+  GF2_STAT_GROW(out, 2*a.words.size());
+  out.resize(2*a.words.size());
+  gf2_words_square(out.data(), a.words.data(), a.words.size());
+  if (&dst == &a)
+    dst.words.swap(out);
+  normalize(dst);
+  reduce(dst, m);
+}
+
+inline gf2_polynomial mulmod(const gf2_polynomial& a, const gf2_polynomial& b, const gf2_modulus& m) {
+  gf2_polynomial r;
+  mulmod_into(r, a, b, m);
+  return r;
+}
+
+inline gf2_polynomial sqrmod(const gf2_polynomial& a, const gf2_modulus& m) {
+  gf2_polynomial r;
+  sqrmod_into(r, a, m);
+  return r;
+}
+
+// a^e mod f by left to right square and multiply
+inline gf2_polynomial powmod(const gf2_polynomial& a, uint64_t e, const gf2_modulus& m) {
+  gf2_polynomial base = a;
+  reduce(base, m);
+  gf2_polynomial result = make_xn(0);
+  reduce(result, m);
+  if (e == 0)
+    return result;
+  for (int bit = 63 - gf2_clz64(e); bit >= 0; --bit) {
+    sqrmod_into(result, result, m);
+    if ((e >> bit) & 1)
+      mulmod_into(result, result, base, m);
+  }
+  return result;
+}
+
+// a^e mod f for an exponent of several words, least significant word first
+inline gf2_polynomial powmod(const gf2_polynomial& a, const std::vector<uint64_t>& e, const gf2_modulus& m) {
+  size_t top = e.size();
+  while (top > 0 && e[top-1] == 0)
+    --top;
+  if (top <= 1)
+    return powmod(a, top ? e[0] : 0, m);
+  gf2_polynomial base = a;
+  reduce(base, m);
+  gf2_polynomial result = base;
+  for (size_t w = top; w-- > 0;) {
+    // the leading one of the top word is already in result
+    for (int bit = w == top-1 ? 62 - gf2_clz64(e[w]) : 63; bit >= 0; --bit) {
+      sqrmod_into(result, result, m);
+      if ((e[w] >> bit) & 1)
+        mulmod_into(result, result, base, m);
+    }
+  }
+  return result;
+}
+
+// x^(2^i) mod f, the table in m grows up to i
+inline const gf2_polynomial& frobenius_power(gf2_modulus& m, uint64_t i) {
+  if (m.frobenius.empty()) {
+    gf2_polynomial x = make_xn(1);
+    reduce(x, m);
+    m.frobenius.push_back(x);
+  }
+  while (m.frobenius.size() <= i)
+    m.frobenius.push_back(sqrmod(m.frobenius.back(), m));
+  return m.frobenius[i];
+}
+
+// a^(2^k) mod f
+inline gf2_polynomial frobenius(const gf2_polynomial& a, uint64_t k, const gf2_modulus& m) {
+  gf2_polynomial r = a;
+  reduce(r, m);
+  for (uint64_t i = 0; i < k; ++i)
+    sqrmod_into(r, r, m);
+  return r;
+}
+
+/*
+Brent-Kung modular composition. The table holds the baby steps b^i mod f for i < s with s = ceil(sqrt(n))
+and the giant step b^s mod f, then a(b) = sum_j a_j(b) (b^s)^j mod f, where the a_j are blocks of s coefficients of a,
+costs n/s modular multiplications in a Horner scheme plus xors of baby steps.
+A table is worth keeping when several polynomials are composed with the same b.
+*/
+struct gf2_composition_table {
+  std::vector<gf2_polynomial> baby;
+  gf2_polynomial giant;
+};
+
+inline gf2_composition_table make_gf2_composition_table(const gf2_polynomial& b, const gf2_modulus& m) {
+  gf2_composition_table t;
+  const uint64_t s = std::max((uint64_t)1, (uint64_t)std::ceil(std::sqrt((double)m.n)));
+  gf2_polynomial base = b;
+  reduce(base, m);
+  gf2_polynomial p = make_xn(0);
+  reduce(p, m);
+  t.baby.reserve(s);
+  for (uint64_t i = 0; i < s; ++i) {
+    t.baby.push_back(p);
+    p = mulmod(p, base, m);
+  }
+  t.giant = std::move(p);
+  return t;
+}
+
+// a(b) mod f where t is the composition table of b
+inline gf2_polynomial compose(const gf2_polynomial& a, const gf2_composition_table& t, const gf2_modulus& m) {
+  gf2_polynomial r;
+  if (is_zero(a))
+    return r;
+  const uint64_t s = t.baby.size();
+  const size_t words = m.n/64 + 1;
+  for (uint64_t j = a.deg/s + 1; j-- > 0;) {
+    if (!is_zero(r))
+      mulmod_into(r, r, t.giant, m);
+    r.words.resize(words, 0);
+    const uint64_t end = std::min(a.deg+1, (j+1)*s);
+    for (uint64_t i = j*s; i < end; ++i) {
+      if (coefficient(a, i)) {
+        const auto& baby = t.baby[i - j*s];
+        for (size_t w = 0; w < baby.words.size(); ++w)
+          r.words[w] ^= baby.words[w];
+      }
+    }
+    normalize(r);
+  }
+  return r;
+}
+
+// a(b) mod f
+inline gf2_polynomial compose(const gf2_polynomial& a, const gf2_polynomial& b, const gf2_modulus& m) {
+  return compose(a, make_gf2_composition_table(b, m), m);
+}
+
+enum gf2_trace_method {
+  gf2_trace_automatic,
+  gf2_trace_squaring,
+  gf2_trace_composition
+};
+
+/*
+A composition costs about sqrt(n) modular products, while squaring is linear with the dedicated kernel,
+so gf2_trace_automatic takes the compositions from d >= c*sqrt(n)*log2(n) on, with c this factor.
+*/
+inline double& gf2_trace_composition_factor() {
+  static double c = 1.0;
+  return c;
+}
+
+// true if k iterated Frobenius steps modulo f are cheaper by composition than by k squarings
+inline bool gf2_frobenius_prefers_composition(uint64_t k, const gf2_modulus& m) {
+  return (double)k >= gf2_trace_composition_factor()*std::sqrt((double)m.n)*std::log2((double)m.n+1);
+}
+
+/*
+Everything the trace map T_d(h) = h + h^2 + h^4 + ... + h^(2^(d-1)) mod f needs that does not depend on h.
+With the von zur Gathen-Shoup doubling T_2k = T_k + T_k^(2^k) = T_k + T_k(x^(2^k)) and T_k+1 = h + T_k^2
+the bits of d are walked from the top, so the trace takes O(log d) compositions instead of d squarings.
+steps holds the composition tables of x^(2^k) mod f for the k where the chain doubles.
+*/
+struct gf2_trace_context {
+  uint64_t d = 0;
+  gf2_trace_method method = gf2_trace_squaring;
+  std::vector<gf2_composition_table> steps;
+};
+
+inline gf2_trace_context make_gf2_trace_context(uint64_t d, const gf2_modulus& m, gf2_trace_method method = gf2_trace_automatic) {
+  gf2_trace_context c;
+  c.d = d;
+  if (method == gf2_trace_automatic)
+    method = gf2_frobenius_prefers_composition(d, m) ? gf2_trace_composition : gf2_trace_squaring;
+  c.method = method;
+  if (method != gf2_trace_composition || d < 2)
+    return c;
+  // xi = x^(2^k) mod f, starting from k = 1
+  gf2_polynomial xi = sqrmod(make_xn(1), m);
+  for (int bit = 62 - gf2_clz64(d); bit >= 0; --bit) {
+    c.steps.push_back(make_gf2_composition_table(xi, m));
+    if (bit == 0)
+      break;
+    xi = compose(xi, c.steps.back(), m);
+    if ((d >> bit) & 1)
+      xi = sqrmod(xi, m);
+  }
+  return c;
+}
+
+// h + h^2 + h^4 + ... + h^(2^(d-1)) mod f
+inline gf2_polynomial trace_map(const gf2_polynomial& h, const gf2_trace_context& c, const gf2_modulus& m) {
+  gf2_polynomial base = h;
+  reduce(base, m);
+  if (c.d == 0)
+    return gf2_polynomial();
+  gf2_polynomial t = base;
+  if (c.method != gf2_trace_composition) {
+    gf2_polynomial last = base;
+    for (uint64_t j = 1; j < c.d; ++j) {
+      sqrmod_into(last, last, m);
+      t += last;
+    }
+    return t;
+  }
+  size_t step = 0;
+  for (int bit = 62 - gf2_clz64(c.d); bit >= 0; --bit) {
+    t += compose(t, c.steps[step++], m);
+    if ((c.d >> bit) & 1) {
+      sqrmod_into(t, t, m);
+      t += base;
+    }
+  }
+  return t;
+}
+
+inline gf2_polynomial trace_map(const gf2_polynomial& h, uint64_t d, const gf2_modulus& m, gf2_trace_method method = gf2_trace_automatic) {
+  return trace_map(h, make_gf2_trace_context(d, m, method), m);
+}
+
+/*
+x^(2^k) mod f. For large k the chain x^(2^2j) = x^(2^j)(x^(2^j)) and x^(2^(j+1)) = (x^(2^j))^2
+walks the bits of k from the top, so it takes O(log k) compositions instead of k squarings.
+*/
+inline gf2_polynomial frobenius_x(uint64_t k, const gf2_modulus& m, gf2_trace_method method = gf2_trace_automatic) {
+  gf2_polynomial xi = make_xn(1);
+  reduce(xi, m);
+  if (k == 0)
+    return xi;
+  if (method == gf2_trace_automatic)
+    method = gf2_frobenius_prefers_composition(k, m) ? gf2_trace_composition : gf2_trace_squaring;
+  if (method != gf2_trace_composition)
+    return frobenius(xi, k, m);
+  xi = sqrmod(xi, m);
+  for (int bit = 62 - gf2_clz64(k); bit >= 0; --bit) {
+    xi = compose(xi, xi, m);
+    if ((k >> bit) & 1)
+      xi = sqrmod(xi, m);
+  }
+  return xi;
+}
+
+/*
+Square free decomposition: pairs (g, e) of square free, pairwise coprime g such that f is the product of the g^e.
+Multiplicities are carried along, also through the square root step for the factors whose multiplicity is even,
+so no powers have to be expanded.
+source: https://en.wikipedia.org/wiki/Factorization_of_polynomials_over_finite_fields
+*/
+inline std::vector<std::pair<gf2_polynomial, uint64_t>> square_free_decomposition(const gf2_polynomial& f) {
+  GF2_STAT_TIMER(gf2_stage_square_free);
+  std::vector<std::pair<gf2_polynomial, uint64_t>> R;
+  if (is_zero(f) || degree(f) == 0)
+    return R;
+  const auto unit = make_xn(0);
+
   //Make w be the product (without multiplicity) of all factors of f that have
   //multiplicity not divisible by p
-    
   auto c = gcd(f, derivative(f));
-  auto w = f/c;
-  
+  gf2_polynomial w, y, fac, rem, scratch;
+  divrem_into(w, rem, f, c);
+
   // Step 1: Identify all factors in w
-  int i = 1;
-  while (w != R.front()) {
-    auto y = gcd(w, c);
-    auto fac = w/y;
-    R.push_back(power(fac, i));
-    w = y;
-    c = c/y;
+  // the loop keeps its temporaries, so the gcds and divisions below reuse their words
+  uint64_t i = 1;
+  while (w != unit) {
+    // y = gcd(w, c)
+    y = w;
+    scratch = c;
+    gcd_in_place(y, scratch);
+    divrem_into(fac, rem, w, y);
+    if (fac != unit)
+      R.push_back(std::make_pair(fac, i));
+    std::swap(w, y);
+    // c = c/y, with y now in w
+    divrem_into(fac, rem, c, w);
+    std::swap(c, fac);
     ++i;
   }
   // c is now the product (with multiplicity) of the remaining factors of f
-   
+
   // Step 2: Identify all remaining factors using recursion
   // Note that these are the factors of f that have multiplicity divisible by p
-  if (c != R.front()) {
-    c = sqrt(c);
-    auto R2 = square_free_factorization(c);
-    for (const auto& factor : R2) {
-      if (factor != R.front())
-        R.push_back(power(factor, 2));
-      }
+  if (c != unit) {
+    for (const auto& factor : square_free_decomposition(sqrt(c)))
+      R.push_back(std::make_pair(factor.first, 2*factor.second));
   }
-  if (R.size()>1)
-    R.erase(R.begin());
   return R;
 }
 
+/*
+The square free decomposition with the powers expanded, in the original layout: entry i-1 is the product of the
+factors of odd multiplicity i raised to the power i, or 1 where there is none, up to the largest odd multiplicity,
+so that multiplicity can be read from the position; the factors g^e of even multiplicity e follow, without 1s.
+Constants and the zero polynomial give {1}.
+*/
+inline std::vector<gf2_polynomial> square_free_factorization(const gf2_polynomial& f) {
+  std::vector<gf2_polynomial> R;
+  const gf2_polynomial unit = make_xn(0);
+  // the odd multiplicities come first and increasing, the even ones from the square root step after them
+  for (const auto& factor : square_free_decomposition(f)) {
+    if (factor.second % 2 == 1)
+      R.resize((size_t)factor.second - 1, unit);
+    R.push_back(power(factor.first, (int)factor.second));
+  }
+  if (R.empty())
+    R.push_back(unit);
+  return R;
+}
+
+enum gf2_ddf_method {
+  gf2_ddf_automatic,
+  gf2_ddf_iterated_frobenius,
+  gf2_ddf_baby_step_giant_step
+};
+
+// from this degree on gf2_ddf_automatic picks the baby step / giant step variant
+inline uint64_t& gf2_ddf_baby_step_giant_step_threshold() {
+  static uint64_t degree = 256;
+  return degree;
+}
+
+/*
+Baby step / giant step distinct degree factorization, see Kaltofen and Shoup,
+"Subquadratic-time factoring of polynomials over finite fields" and Shoup, "A new polynomial factorization algorithm and its implementation".
+With l = ceil(sqrt(n/2)), baby steps h_j = x^(2^j) and giant steps H_k = x^(2^(l*k)) mod f, every irreducible factor of
+degree in (l*(k-1), l*k] divides I_k = prod_(j<l) (H_k - h_j), so one gcd covers l degrees. The gcd is split
+afterwards by the individual H_k - h_j in order of increasing degree l*k-j.
+*/
+inline std::vector<std::pair<gf2_polynomial, uint64_t>> distinct_degree_factorization_baby_step_giant_step(const gf2_polynomial& f) {
+  GF2_STAT_TIMER(gf2_stage_distinct_degree);
+  std::vector<std::pair<gf2_polynomial, uint64_t>> S;
+  const uint64_t n = degree(f);
+  auto unit = make_xn(0);
+  if (n < 2) {
+    S.emplace_back(f, 1);
+    return S;
+  }
+  const uint64_t l = std::max((uint64_t)1, (uint64_t)std::ceil(std::sqrt((double)n/2.0)));
+  gf2_modulus m = make_gf2_modulus(f);
+  std::vector<gf2_polynomial> baby;
+  baby.reserve(l);
+  baby.push_back(make_xn(1) % f);
+  for (uint64_t j = 1; j < l; ++j)
+    baby.push_back(sqrmod(baby.back(), m));
+  gf2_polynomial giant = frobenius(baby.back(), 1, m);
+  auto fstar = f;
+  for (uint64_t k = 1; degree(fstar) >= 2*(l*(k-1)+1); ++k) {
+    gf2_polynomial interval = unit;
+    for (uint64_t j = 0; j < l; ++j)
+      interval = mulmod(interval, giant + baby[j], m);
+    auto g = gcd(fstar, interval);
+    if (g != unit) {
+      fstar = fstar/g;
+      for (uint64_t j = l; j-- > 0 && g != unit;) {
+        auto gj = gcd(g, giant + baby[j]);
+        if (gj != unit) {
+          S.emplace_back(gj, l*k-j);
+          g = g/gj;
+        }
+      }
+    }
+    giant = frobenius(giant, l, m);
+  }
+  if (fstar != unit) {
+    S.emplace_back(fstar, degree(fstar));
+  }
+  if (S.empty())
+    S.emplace_back(f, 1);
+  return S;
+}
+
 //source: https://en.wikipedia.org/wiki/Factorization_of_polynomials_over_finite_fields
-std::vector<std::pair<gf2_polynomial, uint64_t>> distinct_degree_factorization(const gf2_polynomial& f) {
+inline std::vector<std::pair<gf2_polynomial, uint64_t>> distinct_degree_factorization(const gf2_polynomial& f, gf2_ddf_method method = gf2_ddf_automatic) {
 /*
     Input: A monic square-free polynomial f in GF2
     Output: The set of all pairs (g, d), such that
              f has an irreducible factor of degree d and
              g is the product of all monic irreducible factors of f of degree d.
+    x^(2^i) is kept modulo the remaining factor by repeated squaring, so step i costs one modular squaring and a gcd.
 */
+  GF2_STAT_TIMER(gf2_stage_distinct_degree);
+  if (method == gf2_ddf_baby_step_giant_step || (method == gf2_ddf_automatic && degree(f) >= gf2_ddf_baby_step_giant_step_threshold()))
+    return distinct_degree_factorization_baby_step_giant_step(f);
   std::vector<std::pair<gf2_polynomial, uint64_t>> S;
-  int i = 1;
+  uint64_t i = 1;
   auto fstar = f;
   auto unit = make_xn(0);
+  auto x = make_xn(1);
+  gf2_modulus m = make_gf2_modulus(fstar);
+  // h = x^(2^i) mod fstar
+  gf2_polynomial h = x;
   while (degree(fstar)>=2*i) {
-    auto g = gcd(fstar, make_xn((uint64_t)pow(2,i)) - make_xn(1));
+    h = sqrmod(h, m);
+    auto g = gcd(fstar, h - x);
     if (g != unit) {
       S.emplace_back(g, i);
       fstar = fstar/g;
+      m = make_gf2_modulus(fstar);
+      reduce(h, m);
     }
     ++i;
   }
@@ -330,7 +1317,7 @@ std::vector<std::pair<gf2_polynomial, uint64_t>> distinct_degree_factorization(c
   return S;
 }
 
-std::vector<gf2_polynomial> equal_degree_factorization(const gf2_polynomial& f, uint64_t d) {
+inline std::vector<gf2_polynomial> equal_degree_factorization(const gf2_polynomial& f, uint64_t d) {
 /*
 Input: A monic square free polynomial f in GF2 of degree n = rd, which
        has r >= 2 irreducible factors each of degree d.
@@ -338,41 +1325,263 @@ Output: The set of monic irreducible factors of f.
 
 Source for p=2: https://math.stackexchange.com/questions/1636518/how-do-i-apply-the-cantor-zassenhaus-algorithm-to-mathbbf-2
 */
+  GF2_STAT_TIMER(gf2_stage_equal_degree);
   std::vector<gf2_polynomial> factors;
   factors.push_back(f);
   auto unit = make_xn(0);
+  const gf2_modulus modulus = make_gf2_modulus(f);
   
   uint64_t n = degree(f);
   
   uint64_t r = n/d;
+  // the Frobenius tables of the trace map are shared by all trials
+  const gf2_trace_context trace = make_gf2_trace_context(d, modulus);
   
+  // gcd_g_u, scratch, quotient and remainder are reused by all trials
+  gf2_polynomial gcd_g_u, scratch, quotient, remainder;
   while (factors.size() < r) {
+    GF2_STAT(gf2_stat_edf_trial, n);
     auto h = make_random_gf2_polynomial(n-1);
-    auto g = h;
     //g = h + h^2 + h^4 + ... + h^(2^(d-1))
-    auto last_term = h;
-    for (int j = 1; j < d; ++j) {
-      last_term = (last_term*last_term) % f;
-      if (last_term.coefficients.empty())
-        break;
-      g = g + last_term;
-      }
-    //g = g%f;
-    if (g.coefficients.empty())
+    auto g = trace_map(h, trace, modulus);
+    if (is_zero(g)) {
+      GF2_STAT(gf2_stat_edf_failed_split, n);
       continue;
+    }
+    const size_t count = factors.size();
     for (size_t i = 0; i < factors.size(); ++i) {
       const auto& u = factors[i];
       if (degree(u)>d) {
-        auto gcd_g_u = gcd(g, u);
+        gcd_g_u = g;
+        scratch = u;
+        gcd_in_place(gcd_g_u, scratch);
         if (gcd_g_u != unit && gcd_g_u != u) {
-          factors.push_back(u/gcd_g_u);
-          factors[i] = gcd_g_u;  
+          divrem_into(quotient, remainder, u, gcd_g_u);
+          factors[i] = gcd_g_u;
+          factors.push_back(quotient);
         }
       }
     }
+    if (factors.size() == count)
+      GF2_STAT(gf2_stat_edf_failed_split, n);
   }
   
   return factors;
 }
 
+/*
+The Berlekamp matrix Q - I of f with deg(f) = n: row i holds the coefficients of x^(2i) mod f, plus 1 on the diagonal.
+Its left null space is the Berlekamp subalgebra {g : g^2 = g mod f}, whose dimension is the number of irreducible factors.
+*/
+inline gf2_matrix berlekamp_matrix(const gf2_polynomial& f) {
+  const uint64_t n = degree(f);
+  gf2_matrix q = make_gf2_matrix(n, n);
+  gf2_polynomial h = make_xn(0);
+  for (uint64_t i = 0; i < n; ++i) {
+    std::copy(h.words.begin(), h.words.end(), row(q, i));
+    flip_bit(q, i, i);
+    h = mul_xn(h, 2);
+    reduce_in_place(h, f);
+  }
+  return q;
+}
+
+/*
+Berlekamp's algorithm: the irreducible factors of a square free polynomial f.
+Each basis vector g of the Berlekamp subalgebra satisfies g(g+1) = 0 mod f, so gcd(u, g) splits every factor u
+on which g is not constant, and running through the whole basis separates all irreducible factors.
+The null space is found with the M4RI elimination of gf2_matrix.h, which makes this deterministic method
+a good choice for medium degrees.
+*/
+inline std::vector<gf2_polynomial> berlekamp_factorization(const gf2_polynomial& f) {
+  GF2_STAT_TIMER(gf2_stage_berlekamp);
+  std::vector<gf2_polynomial> factors;
+  if (is_zero(f) || degree(f) == 0)
+    return factors;
+  factors.push_back(f);
+  if (degree(f) == 1)
+    return factors;
+  const gf2_matrix basis = left_nullspace(berlekamp_matrix(f));
+  const size_t r = basis.rows;
+  const auto unit = make_xn(0);
+  for (size_t b = 0; b < basis.rows && factors.size() < r; ++b) {
+    std::vector<uint64_t> words(row(basis, b), row(basis, b) + basis.stride);
+    const gf2_polynomial g = make_gf2_polynomial_from_words(std::move(words));
+    if (degree(g) == 0)
+      continue;
+    const size_t count = factors.size();
+    for (size_t i = 0; i < count && factors.size() < r; ++i) {
+      const auto& u = factors[i];
+      if (degree(u) == 1)
+        continue;
+      auto d = gcd(g % u, u);
+      if (d != unit && d != u) {
+        factors.push_back(u/d);
+        factors[i] = d;
+      }
+    }
+  }
+  return factors;
+}
+
+enum gf2_factor_method {
+  gf2_factor_automatic,
+  gf2_factor_cantor_zassenhaus,
+  gf2_factor_berlekamp
+};
+
+// square free parts below this degree are split with Berlekamp by gf2_factor_automatic, larger ones with Cantor-Zassenhaus
+inline uint64_t& gf2_factor_berlekamp_threshold() {
+  static uint64_t deg = 256;
+  return deg;
+}
+
+// the irreducible factors of a square free polynomial f
+inline std::vector<gf2_polynomial> factor_square_free(const gf2_polynomial& f, gf2_factor_method method = gf2_factor_automatic) {
+  if (method == gf2_factor_automatic)
+    method = degree(f) < gf2_factor_berlekamp_threshold() ? gf2_factor_berlekamp : gf2_factor_cantor_zassenhaus;
+  if (method == gf2_factor_berlekamp)
+    return berlekamp_factorization(f);
+  std::vector<gf2_polynomial> factors;
+  if (is_zero(f) || degree(f) == 0)
+    return factors;
+  for (const auto& ddf : distinct_degree_factorization(f)) {
+    if (degree(ddf.first) == ddf.second) {
+      factors.push_back(ddf.first);
+    } else {
+      auto edf = equal_degree_factorization(ddf.first, ddf.second);
+      factors.insert(factors.end(), edf.begin(), edf.end());
+    }
+  }
+  return factors;
+}
+
+// orders polynomials by degree, then by their coefficients from the top down
+inline bool less_by_degree(const gf2_polynomial& a, const gf2_polynomial& b) {
+  if (a.words.size() != b.words.size() || a.deg != b.deg)
+    return a.deg < b.deg || (a.deg == b.deg && a.words.size() < b.words.size());
+  return std::lexicographical_compare(a.words.rbegin(), a.words.rend(), b.words.rbegin(), b.words.rend());
+}
+
+typedef std::vector<std::pair<gf2_polynomial, uint64_t>> gf2_factorization;
+
+/*
+Complete factorization of f into pairs (irreducible factor, multiplicity), sorted by degree.
+The square free decomposition carries the multiplicities, and every square free part is split
+with the method that is fastest for its degree, or the one given.
+*/
+inline gf2_factorization factor(const gf2_polynomial& f, gf2_factor_method method = gf2_factor_automatic) {
+  if (is_zero(f))
+    throw std::runtime_error("factor: zero polynomial!");
+  GF2_STAT_TIMER(gf2_stage_factor);
+  gf2_factorization result;
+  for (const auto& part : square_free_decomposition(f)) {
+    for (auto& p : factor_square_free(part.first, method))
+      result.push_back(std::make_pair(std::move(p), part.second));
+  }
+  std::sort(result.begin(), result.end(), [](const std::pair<gf2_polynomial, uint64_t>& a, const std::pair<gf2_polynomial, uint64_t>& b) {
+    return less_by_degree(a.first, b.first);
+  });
+  return result;
+}
+
+enum gf2_irreducibility_method {
+  gf2_irreducibility_automatic,
+  gf2_irreducibility_rabin,
+  gf2_irreducibility_ben_or
+};
+
+// gf2_irreducibility_automatic looks for factors up to this degree with Ben-Or's test before it certifies with Rabin's
+inline uint64_t& gf2_irreducibility_ben_or_degree() {
+  static uint64_t deg = 16;
+  return deg;
+}
+
+/*
+Ben-Or's test: true if f has no irreducible factor of degree 1..k, that is gcd(x^(2^i) - x, f) = 1 for i <= k.
+A random reducible polynomial almost always has a small factor, so this usually stops after a few steps.
+*/
+inline bool has_no_factor_up_to_degree(const gf2_modulus& m, uint64_t k) {
+  const auto unit = make_xn(0);
+  gf2_polynomial x = make_xn(1);
+  reduce(x, m);
+  gf2_polynomial h = x;
+  for (uint64_t i = 1; i <= k && 2*i <= m.n; ++i) {
+    h = sqrmod(h, m);
+    if (gcd(m.f, h - x) != unit)
+      return false;
+  }
+  return true;
+}
+
+/*
+Rabin's test: f of degree n is irreducible if and only if x^(2^n) = x mod f and gcd(x^(2^(n/p)) - x, f) = 1
+for every prime p dividing n. Costs n Frobenius steps (or O(log n) compositions for large n) and a few gcds.
+*/
+inline bool rabin_irreducibility_test(const gf2_modulus& m) {
+  const uint64_t n = m.n;
+  const auto unit = make_xn(0);
+  // n/p for the prime divisors p of n, in increasing order
+  std::vector<uint64_t> steps;
+  uint64_t r = n;
+  for (uint64_t p = 2; p*p <= r; ++p) {
+    if (r % p == 0) {
+      steps.push_back(n/p);
+      while (r % p == 0)
+        r /= p;
+    }
+  }
+  if (r > 1)
+    steps.push_back(n/r);
+  std::sort(steps.begin(), steps.end());
+  gf2_polynomial x = make_xn(1);
+  reduce(x, m);
+  const bool composition = gf2_frobenius_prefers_composition(n, m);
+  gf2_polynomial h = x;
+  uint64_t k = 0;
+  for (auto s : steps) {
+    h = composition ? frobenius_x(s, m, gf2_trace_composition) : frobenius(h, s - k, m);
+    k = s;
+    if (gcd(m.f, h - x) != unit)
+      return false;
+  }
+  h = composition ? frobenius_x(n, m, gf2_trace_composition) : frobenius(h, n - k, m);
+  return h == x;
+}
+
+/*
+Irreducibility test on a prepared modulus. Factors x and x+1 are ruled out from the coefficients first.
+gf2_irreducibility_automatic runs Ben-Or's test for the low degrees, which rejects most reducible inputs early,
+and certifies the rest with Rabin's test, which is cheaper than Ben-Or's all the way up to n/2.
+*/
+inline bool is_irreducible(const gf2_modulus& m, gf2_irreducibility_method method = gf2_irreducibility_automatic) {
+  const uint64_t n = m.n;
+  if (is_zero(m.f) || n == 0)
+    return false;
+  if (n == 1)
+    return true;
+  // divisible by x, or by x+1 with an even number of terms
+  uint64_t terms = 0;
+  for (auto w : m.f.words)
+    terms += gf2_popcount64(w);
+  if (coefficient(m.f, 0) == 0 || terms % 2 == 0)
+    return false;
+  if (method == gf2_irreducibility_ben_or)
+    return has_no_factor_up_to_degree(m, n/2);
+  if (method == gf2_irreducibility_automatic) {
+    const uint64_t k = std::min(n/2, gf2_irreducibility_ben_or_degree());
+    if (!has_no_factor_up_to_degree(m, k))
+      return false;
+    if (k == n/2)
+      return true;
+  }
+  return rabin_irreducibility_test(m);
+}
+
+inline bool is_irreducible(const gf2_polynomial& f, gf2_irreducibility_method method = gf2_irreducibility_automatic) {
+  if (is_zero(f) || degree(f) == 0)
+    return false;
+  return is_irreducible(make_gf2_modulus(f), method);
+}
+
 #endif
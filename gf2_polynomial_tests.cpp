@@ -1,15 +1,30 @@
 #include "gf2_polynomial_tests.h"
 #include "gf2_polynomial.h"
+#include "gf2_batch_factorization.h"
+#include "gf2_parallel_factorization.h"
+#include "gf2_search.h"
+#include "gf2_poly_fixed.h"
+#include "gf2_field.h"
+#include "gf2_stats.h"
+#include "gf2_crc.h"
+#include "gf2_lfsr.h"
+#include "gf2_serialization.h"
 #include "test_assert.h"
 
+#include <atomic>
+#include <cstdio>
+#include <fstream>
 #include <sstream>
+#include <thread>
 
 namespace {
 
 void test_construction() {
   std::vector<uint8_t> c = {{1,0,0,1,1,0}};
   auto p = make_gf2_polynomial(c);
-  TEST_EQ(p.coefficients.size(), 5);
+  TEST_EQ(degree(p), 4);
+  TEST_EQ(p.words.size(), 1);
+  TEST_EQ(p.words[0], 25);
 }
 
 void test_stream() {
@@ -21,51 +36,24 @@ void test_stream() {
 }
 
 void test_stream_2() {
-  gf2_polynomial g;
-  g.coefficients.push_back(1);
-  g.coefficients.push_back(2);
-  g.coefficients.push_back(3);
-  g.coefficients.push_back(4);
-  g.coefficients.push_back(5);
-  g.coefficients.push_back(6);
+  gf2_polynomial g = make_gf2_polynomial({{1,2,3,4,5,6}});
   std::stringstream ss;
   ss << g;
   TEST_EQ(ss.str(), std::string("X^4 + X^2 + 1"));
 }
 
 void test_degree() {
-  gf2_polynomial g;
-  g.coefficients.push_back(1);
-  g.coefficients.push_back(2);
-  g.coefficients.push_back(3);
-  g.coefficients.push_back(4);
-  g.coefficients.push_back(5);
-  g.coefficients.push_back(6);
+  gf2_polynomial g = make_gf2_polynomial({{1,2,3,4,5,6}});
   TEST_EQ(degree(g), 4);
 }
 
 void test_equal() {
-  gf2_polynomial g1;
-  g1.coefficients.push_back(1);
-  g1.coefficients.push_back(2);
-  g1.coefficients.push_back(3);
-  g1.coefficients.push_back(4);
-  g1.coefficients.push_back(5);
-  g1.coefficients.push_back(6);
-  gf2_polynomial g2;
-  g2.coefficients.push_back(1);
-  g2.coefficients.push_back(0);
-  g2.coefficients.push_back(1);
-  g2.coefficients.push_back(0);
-  g2.coefficients.push_back(1);
+  gf2_polynomial g1 = make_gf2_polynomial({{1,2,3,4,5,6}});
+  gf2_polynomial g2 = make_gf2_polynomial({{1,0,1,0,1}});
   TEST_ASSERT(g1==g2);
   
   gf2_polynomial g3;
-  gf2_polynomial g4;
-  g4.coefficients.push_back(2);
-  g4.coefficients.push_back(4);
-  g4.coefficients.push_back(6);
-  g4.coefficients.push_back(8);
+  gf2_polynomial g4 = make_gf2_polynomial({{2,4,6,8}});
   TEST_ASSERT(g3==g4);
   TEST_ASSERT(g1!=g3);
   TEST_ASSERT(g1!=g4);
@@ -176,6 +164,30 @@ void test_square_free_factorization() {
   TEST_ASSERT(gf2_polynomial_to_hex(p) == gf2_polynomial_to_hex(g));
 }
 
+// entry i-1 holds the factors of multiplicity i, with 1 where there are none
+void test_square_free_factorization_layout() {
+  // (x^4+x^3+x^2+x+1) * (x+1)^3
+  auto R = square_free_factorization(hex_to_gf2_polynomial("a5"));
+  TEST_EQ(3, R.size());
+  TEST_ASSERT(gf2_polynomial_to_hex(R[0]) == std::string("1f"));
+  TEST_ASSERT(gf2_polynomial_to_hex(R[1]) == std::string("1"));
+  TEST_ASSERT(gf2_polynomial_to_hex(R[2]) == std::string("f"));
+  // x^4 * (x+1)^3: the even multiplicity comes after the odd ones
+  R = square_free_factorization(hex_to_gf2_polynomial("f0"));
+  TEST_EQ(4, R.size());
+  TEST_ASSERT(gf2_polynomial_to_hex(R[0]) == std::string("1"));
+  TEST_ASSERT(gf2_polynomial_to_hex(R[1]) == std::string("1"));
+  TEST_ASSERT(gf2_polynomial_to_hex(R[2]) == std::string("f"));
+  TEST_ASSERT(gf2_polynomial_to_hex(R[3]) == std::string("10"));
+  // all multiplicities even, and a constant
+  R = square_free_factorization(hex_to_gf2_polynomial("14"));
+  TEST_EQ(1, R.size());
+  TEST_ASSERT(gf2_polynomial_to_hex(R[0]) == std::string("14"));
+  R = square_free_factorization(make_xn(0));
+  TEST_EQ(1, R.size());
+  TEST_ASSERT(R[0] == make_xn(0));
+}
+
 void test_distinct_degree_factorization() {
   gf2_polynomial g = make_gf2_polynomial({{0,0,1,1,0,1,0,0,1}});
   auto S = distinct_degree_factorization(g);
@@ -206,11 +218,1597 @@ void test_equal_degree_factorization_2() {
   TEST_ASSERT(gf2_polynomial_to_hex(factors[0]) == std::string("cd55") || gf2_polynomial_to_hex(factors[1]) == std::string("cd55"));
 }
 
+
+void test_coefficients_roundtrip() {
+  std::vector<uint8_t> c(200, 0);
+  for (size_t i = 0; i < c.size(); ++i)
+    c[i] = (i*i+3*i)%7 < 3 ? 1 : 0;
+  c.back() = 1;
+  auto p = make_gf2_polynomial(c);
+  TEST_EQ(degree(p), 199);
+  TEST_EQ(p.words.size(), 4);
+  TEST_ASSERT(gf2_polynomial_to_coefficients(p) == c);
+  for (size_t i = 0; i < c.size(); ++i)
+    TEST_EQ((int)c[i], coefficient(p, i));
+  TEST_EQ(0, coefficient(p, 1000));
+}
+
+void test_clmul64_portable() {
+  uint64_t a = 0xfedcba9876543210ULL;
+  for (int k = 0; k < 64; ++k) {
+    uint64_t b = 0xe1f0c3a5968778d2ULL * (uint64_t)(k+1);
+    uint64_t lo = 0, hi = 0;
+    for (int i = 0; i < 64; ++i) {
+      if ((a >> i) & 1) {
+        lo ^= b << i;
+        if (i)
+          hi ^= b >> (64-i);
+      }
+    }
+    uint64_t h;
+    uint64_t l = gf2_clmul64_portable(a, b, h);
+    TEST_EQ(lo, l);
+    TEST_EQ(hi, h);
+    a = a*6364136223846793005ULL + 1442695040888963407ULL;
+  }
+}
+
+void test_multi_word_arithmetic() {
+  gf2_random_engine().seed(1);
+  for (int k = 0; k < 10; ++k) {
+    gf2_polynomial a = make_random_gf2_polynomial(300+37*k);
+    gf2_polynomial b = make_random_gf2_polynomial(130+11*k);
+    auto ab = a*b;
+    TEST_EQ(degree(a)+degree(b), degree(ab));
+    TEST_ASSERT(ab/b == a);
+    TEST_ASSERT(is_zero(ab%b));
+    auto c = ab + make_xn(5);
+    auto div = euclidean_division(c, b);
+    TEST_ASSERT(div.first*b + div.second == c);
+    TEST_ASSERT(degree(div.second) < degree(b));
+    TEST_ASSERT(a*b == b*a);
+    TEST_ASSERT(is_zero(a+a));
+  }
+  gf2_polynomial x200 = make_xn(200);
+  TEST_EQ(degree(x200), 200);
+  TEST_ASSERT(x200*make_xn(100) == make_xn(300));
+  TEST_ASSERT(sqrt(make_xn(300)) == make_xn(150));
+}
+
+void test_hex_multi_word() {
+  std::string h("1f0e2d3c4b5a69788796a5b4c3d2e1f00123456789abcdef");
+  TEST_EQ(h, gf2_polynomial_to_hex(hex_to_gf2_polynomial(h)));
+  TEST_EQ(degree(hex_to_gf2_polynomial(h)), 4*h.size()-4);
+  TEST_EQ(std::string("1"), gf2_polynomial_to_hex(hex_to_gf2_polynomial("0001")));
+}
+
+void test_mul_kernels() {
+  gf2_random_engine().seed(2);
+  const gf2_mul_kernel kernels[] = {gf2_mul_kernel_portable, gf2_mul_kernel_pclmul, gf2_mul_kernel_vpclmul};
+  const gf2_mul_kernel active = gf2_active_mul_kernel();
+  for (int na = 1; na < 24; na += 3) {
+    for (int nb = 1; nb < 40; nb += 5) {
+      gf2_polynomial a = make_random_gf2_polynomial(64*na-1);
+      gf2_polynomial b = make_random_gf2_polynomial(64*nb-1);
+      std::vector<uint64_t> expected(a.words.size()+b.words.size());
+      gf2_words_mul_schoolbook(expected.data(), a.words.data(), a.words.size(), b.words.data(), b.words.size());
+      for (auto k : kernels) {
+        if (!gf2_mul_kernel_supported(k))
+          continue;
+        gf2_set_mul_kernel(k);
+        std::vector<uint64_t> r(a.words.size()+b.words.size(), 0xffffffffffffffffULL);
+        gf2_words_mul_basecase(r.data(), a.words.data(), a.words.size(), b.words.data(), b.words.size());
+        TEST_ASSERT(r == expected);
+        TEST_ASSERT(a*b == make_gf2_polynomial_from_words(expected));
+      }
+    }
+  }
+  gf2_set_mul_kernel(active);
+  uint64_t h1, h2;
+  TEST_EQ(gf2_clmul64_portable(0x87654321fedcba98ULL, 0xf0e1d2c3b4a59687ULL, h1), gf2_clmul64(0x87654321fedcba98ULL, 0xf0e1d2c3b4a59687ULL, h2));
+  TEST_EQ(h1, h2);
+}
+
+void test_subquadratic_mul() {
+  gf2_random_engine().seed(3);
+  const gf2_mul_thresholds saved = gf2_active_mul_thresholds();
+  const gf2_mul_thresholds settings[] = {{2, 1000000, 1000000}, {2, 3, 1000000}, {4, 9, 1000000}, {2, 3, 12}};
+  const int sizes[][2] = {{2,2}, {3,2}, {5,5}, {7,4}, {9,8}, {16,3}, {17,17}, {33,31}, {40,14}, {61,60}, {100,73}};
+  for (const auto& t : settings) {
+    gf2_active_mul_thresholds() = t;
+    for (const auto& sz : sizes) {
+      gf2_polynomial a = make_random_gf2_polynomial(64*sz[0]-1-(int)(gf2_random_engine()()%5));
+      gf2_polynomial b = make_random_gf2_polynomial(64*sz[1]-1-(int)(gf2_random_engine()()%5));
+      std::vector<uint64_t> expected(a.words.size()+b.words.size());
+      gf2_words_mul_schoolbook(expected.data(), a.words.data(), a.words.size(), b.words.data(), b.words.size());
+      TEST_ASSERT(a*b == make_gf2_polynomial_from_words(expected));
+      TEST_ASSERT(b*a == make_gf2_polynomial_from_words(expected));
+    }
+  }
+  gf2_active_mul_thresholds() = saved;
+}
+
+void test_divide_by_x_plus_1() {
+  gf2_polynomial a = make_random_gf2_polynomial(500);
+  gf2_polynomial c = a*make_gf2_polynomial({{1,1}});
+  c.words.push_back(0);
+  gf2_words_divide_by_x_plus_1(c.words.data(), c.words.size());
+  normalize(c);
+  TEST_ASSERT(a == c);
+}
+
+void test_cantor_basis() {
+  const uint64_t* beta = gf2_cantor_basis();
+  TEST_EQ(1, beta[0]);
+  for (int i = 1; i < 64; ++i)
+    TEST_EQ(beta[i-1], gf2_gf64_mul(beta[i], beta[i]) ^ beta[i]);
+  TEST_EQ(0x1b, gf2_gf64_mul(0x8000000000000000ULL, 2));
+}
+
+void test_fft_mul() {
+  gf2_random_engine().seed(4);
+  const gf2_mul_kernel kernels[] = {gf2_mul_kernel_portable, gf2_mul_kernel_pclmul, gf2_mul_kernel_vpclmul};
+  const size_t sizes[][2] = {{1,1}, {3,2}, {16,16}, {33,7}, {100,100}, {257,130}};
+  for (auto k : kernels) {
+    if (!gf2_mul_kernel_supported(k))
+      continue;
+    for (const auto& sz : sizes) {
+      gf2_polynomial a = make_random_gf2_polynomial(64*sz[0]-1);
+      gf2_polynomial b = make_random_gf2_polynomial(64*sz[1]-1);
+      std::vector<uint64_t> expected(a.words.size()+b.words.size());
+      gf2_words_mul_schoolbook(expected.data(), a.words.data(), a.words.size(), b.words.data(), b.words.size());
+      std::vector<uint64_t> r(expected.size(), 0xffffffffffffffffULL);
+      gf2_words_mul_fft(r.data(), a.words.data(), a.words.size(), b.words.data(), b.words.size(), k != gf2_mul_kernel_portable, k == gf2_mul_kernel_vpclmul);
+      TEST_ASSERT(r == expected);
+      std::vector<uint64_t> sq(2*a.words.size());
+      gf2_words_mul_fft(sq.data(), a.words.data(), a.words.size(), a.words.data(), a.words.size(), k != gf2_mul_kernel_portable, k == gf2_mul_kernel_vpclmul);
+      TEST_ASSERT(make_gf2_polynomial_from_words(sq) == a*a);
+    }
+  }
+}
+
+void test_calibrate_mul_thresholds() {
+  const gf2_mul_thresholds saved = gf2_active_mul_thresholds();
+  gf2_mul_thresholds t = gf2_calibrate_mul_thresholds();
+  TEST_ASSERT(t.karatsuba >= 4);
+  TEST_ASSERT(t.toom3 >= t.karatsuba);
+  TEST_ASSERT(t.fft >= 2048);
+  TEST_EQ(t.karatsuba, gf2_active_mul_thresholds().karatsuba);
+  gf2_polynomial a = make_random_gf2_polynomial(64*300);
+  gf2_polynomial b = make_random_gf2_polynomial(64*250);
+  TEST_ASSERT((a*b)/b == a);
+  gf2_active_mul_thresholds() = saved;
+}
+
+void test_shifts_and_reversal() {
+  gf2_polynomial p = hex_to_gf2_polynomial("1f0e2d3c4b5a69788796a5b4c3d2e1f0");
+  TEST_ASSERT(mul_xn(p, 77) == p*make_xn(77));
+  TEST_ASSERT(div_xn(mul_xn(p, 77), 77) == p);
+  TEST_ASSERT(div_xn(p, 4) == hex_to_gf2_polynomial("1f0e2d3c4b5a69788796a5b4c3d2e1f"));
+  TEST_ASSERT(mod_xn(p, 8) == hex_to_gf2_polynomial("f0"));
+  TEST_ASSERT(mod_xn(p, 200) == p);
+  TEST_ASSERT(reversal(make_gf2_polynomial({{1,1,0,1}}), 3) == make_gf2_polynomial({{1,0,1,1}}));
+  TEST_ASSERT(reversal(make_gf2_polynomial({{0,1}}), 70) == make_xn(69));
+  for (uint64_t n = degree(p); n < degree(p)+130; n += 13)
+    TEST_ASSERT(reversal(reversal(p, n), n) == p);
+  TEST_ASSERT(reversal(reversal(p, 200), 200) == p);
+}
+
+void test_newton_inverse() {
+  gf2_random_engine().seed(5);
+  for (uint64_t k : {1, 2, 63, 64, 65, 300, 1000}) {
+    gf2_polynomial g = make_random_gf2_polynomial(400);
+    if (coefficient(g, 0) == 0)
+      g = g + make_xn(0);
+    gf2_polynomial h = newton_inverse(g, k);
+    TEST_ASSERT(degree(h) < k);
+    TEST_ASSERT(mod_xn(g*h, k) == make_xn(0));
+  }
+}
+
+void test_newton_division() {
+  gf2_random_engine().seed(6);
+  const size_t saved = gf2_newton_division_threshold();
+  for (int k = 0; k < 8; ++k) {
+    gf2_polynomial a = make_random_gf2_polynomial(1500+97*k);
+    gf2_polynomial b = make_random_gf2_polynomial(200+61*k);
+    gf2_newton_division_threshold() = 1000000;
+    auto expected = euclidean_division(a, b);
+    gf2_newton_division_threshold() = 1;
+    TEST_ASSERT(use_newton_division(a, b));
+    auto div = euclidean_division(a, b);
+    TEST_ASSERT(div.first == expected.first);
+    TEST_ASSERT(div.second == expected.second);
+    TEST_ASSERT(a % b == expected.second);
+    TEST_ASSERT(gcd(a, b) == gcd(b, a));
+  }
+  gf2_newton_division_threshold() = saved;
+}
+
+void test_modulus() {
+  gf2_random_engine().seed(7);
+  const size_t saved = gf2_newton_division_threshold();
+  std::vector<gf2_polynomial> moduli;
+  moduli.push_back(make_random_gf2_polynomial(1200) + make_xn(1201));
+  moduli.push_back(make_xn(233) + make_xn(74) + make_xn(0));
+  moduli.push_back(make_xn(571) + make_xn(10) + make_xn(5) + make_xn(2) + make_xn(0));
+  moduli.push_back(make_xn(127) + make_xn(126) + make_xn(0));
+  moduli.push_back(make_xn(100));
+  moduli.push_back(hex_to_gf2_polynomial("73af"));
+  for (size_t threshold : {(size_t)1, (size_t)16}) {
+    gf2_newton_division_threshold() = threshold;
+    for (const auto& f : moduli) {
+      gf2_modulus m = make_gf2_modulus(f);
+      TEST_EQ(degree(f), m.n);
+      gf2_polynomial a = make_random_gf2_polynomial(degree(f)-1);
+      gf2_polynomial b = make_random_gf2_polynomial(degree(f)-1);
+      TEST_ASSERT(mulmod(a, b, m) == (a*b) % f);
+      TEST_ASSERT(sqrmod(a, m) == (a*a) % f);
+      gf2_polynomial big = make_random_gf2_polynomial(5*degree(f));
+      gf2_polynomial r = big;
+      reduce(r, m);
+      TEST_ASSERT(r == big % f);
+      gf2_polynomial p = make_xn(0);
+      for (int i = 0; i < 11; ++i)
+        p = (p*a) % f;
+      TEST_ASSERT(powmod(a, 11, m) == p);
+      TEST_ASSERT(frobenius(a, 3, m) == powmod(a, 8, m));
+      TEST_ASSERT(frobenius_power(m, 5) == powmod(make_xn(1), 32, m));
+      TEST_ASSERT(frobenius_power(m, 0) == make_xn(1) % f);
+    }
+  }
+  TEST_EQ(2, make_gf2_modulus(moduli[1]).sparse_terms.size());
+  TEST_EQ(4, make_gf2_modulus(moduli[2]).sparse_terms.size());
+  TEST_EQ(0, make_gf2_modulus(moduli[0]).sparse_terms.size());
+  gf2_newton_division_threshold() = saved;
+}
+
+void test_sparse_division() {
+  gf2_random_engine().seed(27);
+  const size_t saved = gf2_newton_division_threshold();
+  std::vector<gf2_polynomial> divisors;
+  divisors.push_back(make_xn(8) + make_xn(4) + make_xn(3) + make_xn(1) + make_xn(0));
+  divisors.push_back(make_xn(64) + make_xn(32) + make_xn(0));
+  divisors.push_back(make_xn(100));
+  divisors.push_back(make_xn(163) + make_xn(7) + make_xn(6) + make_xn(3) + make_xn(0));
+  divisors.push_back(make_xn(233) + make_xn(74) + make_xn(0));
+  divisors.push_back(make_xn(1279) + make_xn(216) + make_xn(0));
+  uint64_t terms[4];
+  for (const auto& b : divisors) {
+    TEST_ASSERT(gf2_sparse_terms(b, terms) >= 0);
+    for (size_t threshold : {(size_t)1, (size_t)16}) {
+      gf2_newton_division_threshold() = threshold;
+      for (uint64_t len : {degree(b) - 1, degree(b), degree(b) + 1, 3*degree(b) + 70, 20*degree(b)}) {
+        gf2_polynomial a = make_random_gf2_polynomial(len) + make_xn(len);
+        // the dense shift-xor loop as reference
+        gf2_polynomial r = a;
+        gf2_polynomial q;
+        if (len >= degree(b))
+          q.words.resize((len - degree(b))/64+1, 0);
+        reduce_in_place(r, b, &q);
+        normalize(q);
+        auto qr = euclidean_division(a, b);
+        TEST_ASSERT(qr.first == q);
+        TEST_ASSERT(qr.second == r);
+        TEST_ASSERT(a % b == r);
+        TEST_ASSERT(gcd(a, b) == gcd_euclidean(b, r));
+      }
+    }
+  }
+  // dense, too heavy, a middle term above n/2 or below degree 8
+  TEST_EQ(-1, gf2_sparse_terms(make_random_gf2_polynomial(199) + make_xn(200), terms));
+  TEST_EQ(-1, gf2_sparse_terms(make_xn(200) + make_xn(9) + make_xn(7) + make_xn(5) + make_xn(3) + make_xn(0), terms));
+  TEST_EQ(-1, gf2_sparse_terms(make_xn(127) + make_xn(126) + make_xn(0), terms));
+  TEST_EQ(-1, gf2_sparse_terms(hex_to_gf2_polynomial("13"), terms));
+  TEST_EQ(4, gf2_sparse_terms(divisors[3], terms));
+  TEST_EQ(7, terms[0]);
+  TEST_EQ(0, terms[3]);
+  TEST_EQ(0, gf2_sparse_terms(make_xn(100), terms));
+  gf2_newton_division_threshold() = saved;
+}
+
+void test_distinct_degree_factorization_large_degrees() {
+  // x^127+x+1 and x^89+x^38+1 are irreducible, 0x13 = x^4+x+1 and 0xb = x^3+x+1 too
+  gf2_polynomial p127 = make_xn(127) + make_xn(1) + make_xn(0);
+  gf2_polynomial p89 = make_xn(89) + make_xn(38) + make_xn(0);
+  gf2_polynomial g = p127*p89*hex_to_gf2_polynomial("13")*hex_to_gf2_polynomial("b")*make_gf2_polynomial({{1,1}});
+  for (auto method : {gf2_ddf_iterated_frobenius, gf2_ddf_baby_step_giant_step, gf2_ddf_automatic}) {
+    auto S = distinct_degree_factorization(g, method);
+    TEST_EQ(5, S.size());
+    auto p = make_xn(0);
+    for (const auto& s : S)
+      p = p*s.first;
+    TEST_ASSERT(p == g);
+    TEST_EQ(1, S[0].second);
+    TEST_EQ(3, S[1].second);
+    TEST_EQ(4, S[2].second);
+    TEST_EQ(89, S[3].second);
+    TEST_ASSERT(S[3].first == p89);
+    TEST_EQ(127, S[4].second);
+  }
+}
+
+void test_distinct_degree_factorization_methods_agree() {
+  gf2_random_engine().seed(8);
+  for (int k = 0; k < 6; ++k) {
+    gf2_polynomial f = make_random_gf2_polynomial(150+40*k);
+    if (degree(gcd(f, derivative(f))) > 0)
+      continue;
+    auto S1 = distinct_degree_factorization(f, gf2_ddf_iterated_frobenius);
+    auto S2 = distinct_degree_factorization(f, gf2_ddf_baby_step_giant_step);
+    TEST_EQ(S1.size(), S2.size());
+    for (size_t i = 0; i < S1.size() && i < S2.size(); ++i) {
+      TEST_EQ(S1[i].second, S2[i].second);
+      TEST_ASSERT(S1[i].first == S2[i].first);
+      TEST_EQ(0, degree(S1[i].first) % S1[i].second);
+    }
+  }
+}
+
+void test_half_gcd() {
+  const uint64_t saved = gf2_half_gcd_recursion_threshold();
+  gf2_half_gcd_recursion_threshold() = 16;
+  gf2_random_engine().seed(9);
+  for (uint64_t n : {20, 63, 64, 65, 200, 513, 1500}) {
+    gf2_polynomial a = make_random_gf2_polynomial(n-1) + make_xn(n);
+    gf2_polynomial b = make_random_gf2_polynomial(n-1);
+    // the classical remainder sequence stops at the same pair
+    gf2_polynomial c(a), d(b);
+    while (signed_degree(d) > (int64_t)n/2) {
+      gf2_polynomial r = c % d;
+      c = d;
+      d = r;
+    }
+    gf2_polynomial_matrix2 M;
+    gf2_polynomial e(a), f(b);
+    half_gcd_in_place(e, f, M);
+    TEST_ASSERT(e == c);
+    TEST_ASSERT(f == d);
+    TEST_ASSERT(e == M.m00*a + M.m01*b);
+    TEST_ASSERT(f == M.m10*a + M.m11*b);
+  }
+  gf2_half_gcd_recursion_threshold() = saved;
+}
+
+void test_gcd_half_gcd() {
+  const uint64_t saved = gf2_half_gcd_threshold();
+  const uint64_t saved_recursion = gf2_half_gcd_recursion_threshold();
+  gf2_half_gcd_recursion_threshold() = 16;
+  gf2_random_engine().seed(10);
+  for (uint64_t threshold : {16, 100, 1024}) {
+    gf2_half_gcd_threshold() = threshold;
+    for (uint64_t n : {10, 300, 2000, 5000}) {
+      gf2_polynomial c = make_random_gf2_polynomial(n/3 - 1) + make_xn(n/3);
+      gf2_polynomial a = c * (make_random_gf2_polynomial(n-1) + make_xn(n));
+      gf2_polynomial b = c * make_random_gf2_polynomial(n-7);
+      gf2_polynomial g = gcd(a, b);
+      TEST_ASSERT(g == gcd_euclidean(a, b));
+      TEST_ASSERT(is_zero(a % g));
+      TEST_ASSERT(is_zero(b % g));
+      TEST_ASSERT(is_zero(g % c));
+      TEST_ASSERT(gcd(b, a) == g);
+    }
+  }
+  TEST_ASSERT(gcd(gf2_polynomial(), make_xn(5)) == make_xn(5));
+  TEST_ASSERT(is_zero(gcd(gf2_polynomial(), gf2_polynomial())));
+  gf2_half_gcd_threshold() = saved;
+  gf2_half_gcd_recursion_threshold() = saved_recursion;
+}
+
+void test_extended_gcd() {
+  const uint64_t saved = gf2_half_gcd_threshold();
+  const uint64_t saved_recursion = gf2_half_gcd_recursion_threshold();
+  gf2_half_gcd_recursion_threshold() = 16;
+  gf2_random_engine().seed(11);
+  for (uint64_t threshold : {16, 1024}) {
+    gf2_half_gcd_threshold() = threshold;
+    for (uint64_t n : {5, 70, 700, 3000}) {
+      gf2_polynomial c = make_random_gf2_polynomial(n/4 - 1) + make_xn(n/4);
+      gf2_polynomial a = c * (make_random_gf2_polynomial(n-2) + make_xn(n-1));
+      gf2_polynomial b = c * (make_random_gf2_polynomial(n/2 - 1) + make_xn(n/2));
+      gf2_polynomial s, t;
+      gf2_polynomial g = extended_gcd(a, b, s, t);
+      TEST_ASSERT(g == gcd_euclidean(a, b));
+      TEST_ASSERT(s*a + t*b == g);
+      if (degree(g) < degree(b)) {
+        TEST_ASSERT(degree(s) < degree(b));
+        TEST_ASSERT(degree(t) < degree(a));
+      }
+      g = extended_gcd(b, a, s, t);
+      TEST_ASSERT(s*b + t*a == g);
+    }
+  }
+  gf2_polynomial s, t;
+  gf2_polynomial g = extended_gcd(gf2_polynomial(), make_xn(3), s, t);
+  TEST_ASSERT(g == make_xn(3));
+  TEST_ASSERT(t*make_xn(3) == g);
+  gf2_half_gcd_threshold() = saved;
+  gf2_half_gcd_recursion_threshold() = saved_recursion;
+}
+
+void test_modular_inverse() {
+  // x^127+x+1 is irreducible
+  gf2_polynomial f = make_xn(127) + make_xn(1) + make_xn(0);
+  gf2_random_engine().seed(12);
+  const uint64_t saved = gf2_half_gcd_threshold();
+  const uint64_t saved_recursion = gf2_half_gcd_recursion_threshold();
+  gf2_half_gcd_recursion_threshold() = 16;
+  gf2_half_gcd_threshold() = 16;
+  for (int i = 0; i < 10; ++i) {
+    gf2_polynomial a = make_random_gf2_polynomial(126);
+    if (is_zero(a))
+      continue;
+    gf2_polynomial inv = modular_inverse(a, f);
+    TEST_ASSERT(degree(inv) < 127);
+    TEST_ASSERT((a*inv) % f == make_xn(0));
+  }
+  gf2_half_gcd_threshold() = saved;
+  gf2_half_gcd_recursion_threshold() = saved_recursion;
+  TEST_ASSERT(modular_inverse(hex_to_gf2_polynomial("2"), hex_to_gf2_polynomial("13")) == hex_to_gf2_polynomial("9"));
+  bool thrown = false;
+  try {
+    modular_inverse(make_gf2_polynomial({{1,1}}), make_gf2_polynomial({{1,0,1}}));
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+}
+
+gf2_matrix make_random_gf2_matrix(size_t rows, size_t cols) {
+  gf2_matrix m = make_gf2_matrix(rows, cols);
+  for (size_t i = 0; i < rows; ++i)
+    for (size_t j = 0; j < cols; ++j)
+      if (gf2_random_engine()() & 1)
+        set_bit(m, i, j, 1);
+  return m;
+}
+
+void test_gf2_matrix_echelon_form() {
+  gf2_random_engine().seed(13);
+  for (size_t n : {1, 5, 64, 65, 130, 300}) {
+    for (size_t extra : {0, 3, 70}) {
+      gf2_matrix a = make_random_gf2_matrix(n, n + extra);
+      // a rank deficient matrix: the last rows are sums of earlier ones
+      for (size_t i = n/2; i < n; ++i)
+        for (size_t w = 0; w < a.stride; ++w)
+          row(a, i)[w] = row(a, i-n/2)[w] ^ row(a, (i*7)%(n/2+1))[w];
+      gf2_matrix b(a);
+      const size_t rank = echelon_form_gauss(b);
+      for (int k : {0, 1, 3, 8}) {
+        gf2_matrix c(a);
+        TEST_EQ(rank, echelon_form_m4ri(c, 0, k));
+        // echelon form: the leading bit of each row lies right of the one above, and the rest is zero
+        size_t lead = 0;
+        for (size_t i = 0; i < c.rows; ++i) {
+          size_t j = 0;
+          while (j < c.cols && !get_bit(c, i, j))
+            ++j;
+          if (i < rank) {
+            TEST_ASSERT(j < c.cols);
+            TEST_ASSERT(i == 0 || j > lead);
+            lead = j;
+          }
+          else
+            TEST_EQ(c.cols, j);
+        }
+      }
+    }
+  }
+}
+
+void test_gf2_matrix_left_nullspace() {
+  gf2_random_engine().seed(14);
+  for (size_t n : {1, 10, 64, 100, 257}) {
+    gf2_matrix a = make_random_gf2_matrix(n, n/2+1);
+    gf2_matrix b(a);
+    const size_t rank = echelon_form_gauss(b);
+    gf2_matrix N = left_nullspace(a);
+    TEST_EQ(n - rank, N.rows);
+    gf2_matrix zero = N*a;
+    TEST_ASSERT(zero == make_gf2_matrix(N.rows, a.cols));
+    gf2_matrix c(N);
+    TEST_EQ(N.rows, echelon_form_gauss(c));
+  }
+  gf2_matrix I = make_identity_gf2_matrix(70);
+  TEST_EQ(0, left_nullspace(I).rows);
+  TEST_ASSERT(I*I == I);
+}
+
+void test_berlekamp_factorization() {
+  // x^127+x+1, x^89+x^38+1, x^4+x+1, x^3+x+1, x^3+x^2+1 and x+1 are irreducible
+  std::vector<gf2_polynomial> irreducible;
+  irreducible.push_back(make_xn(127) + make_xn(1) + make_xn(0));
+  irreducible.push_back(make_xn(89) + make_xn(38) + make_xn(0));
+  irreducible.push_back(hex_to_gf2_polynomial("13"));
+  irreducible.push_back(hex_to_gf2_polynomial("b"));
+  irreducible.push_back(hex_to_gf2_polynomial("d"));
+  irreducible.push_back(hex_to_gf2_polynomial("3"));
+  irreducible.push_back(hex_to_gf2_polynomial("2"));
+  gf2_polynomial f = make_xn(0);
+  for (const auto& p : irreducible)
+    f = f*p;
+  auto factors = berlekamp_factorization(f);
+  TEST_EQ(irreducible.size(), factors.size());
+  for (const auto& p : irreducible)
+    TEST_ASSERT(std::find(factors.begin(), factors.end(), p) != factors.end());
+  factors = berlekamp_factorization(irreducible[0]);
+  TEST_EQ(1, factors.size());
+  TEST_ASSERT(factors[0] == irreducible[0]);
+  TEST_EQ(0, berlekamp_factorization(make_xn(0)).size());
+
+  // agrees with distinct and equal degree factorization on random square free polynomials
+  gf2_random_engine().seed(15);
+  for (int k = 0; k < 5; ++k) {
+    gf2_polynomial g = make_random_gf2_polynomial(99 + 60*k) + make_xn(100 + 60*k);
+    if (degree(gcd(g, derivative(g))) > 0)
+      continue;
+    std::vector<gf2_polynomial> expected;
+    for (const auto& ddf : distinct_degree_factorization(g)) {
+      if (degree(ddf.first) == ddf.second) {
+        expected.push_back(ddf.first);
+        continue;
+      }
+      auto edf = equal_degree_factorization(ddf.first, ddf.second);
+      expected.insert(expected.end(), edf.begin(), edf.end());
+    }
+    factors = berlekamp_factorization(g);
+    TEST_EQ(expected.size(), factors.size());
+    gf2_polynomial p = make_xn(0);
+    for (const auto& u : factors) {
+      TEST_ASSERT(std::find(expected.begin(), expected.end(), u) != expected.end());
+      p = p*u;
+    }
+    TEST_ASSERT(p == g);
+  }
+}
+
+void test_power() {
+  gf2_polynomial g = hex_to_gf2_polynomial("b");
+  gf2_polynomial p = make_xn(0);
+  for (int i = 0; i <= 13; ++i) {
+    TEST_ASSERT(power(g, i) == p);
+    p = p*g;
+  }
+  TEST_ASSERT(power(g, -1) == make_xn(0));
+}
+
+void test_square_free_decomposition() {
+  // (x+1)^3 * x^2 * (x^2+x+1)^4 * (x^4+x+1)
+  gf2_polynomial f = power(hex_to_gf2_polynomial("3"), 3) * power(hex_to_gf2_polynomial("2"), 2) * power(hex_to_gf2_polynomial("7"), 4) * hex_to_gf2_polynomial("13");
+  auto R = square_free_decomposition(f);
+  gf2_polynomial p = make_xn(0);
+  for (const auto& r : R) {
+    TEST_EQ(0, degree(gcd(r.first, derivative(r.first))));
+    p = p*power(r.first, (int)r.second);
+  }
+  TEST_ASSERT(p == f);
+  TEST_EQ(4, R.size());
+  // x^4+x+1, the placeholder for multiplicity 2, (x+1)^3, then x^2 and (x^2+x+1)^4
+  auto S = square_free_factorization(f);
+  TEST_EQ(R.size()+1, S.size());
+  TEST_ASSERT(S[1] == make_xn(0));
+  TEST_EQ(0, square_free_decomposition(make_xn(0)).size());
+}
+
+void test_factor() {
+  std::vector<std::pair<gf2_polynomial, uint64_t>> expected;
+  expected.push_back(std::make_pair(hex_to_gf2_polynomial("2"), 2));
+  expected.push_back(std::make_pair(hex_to_gf2_polynomial("3"), 3));
+  expected.push_back(std::make_pair(hex_to_gf2_polynomial("7"), 4));
+  expected.push_back(std::make_pair(hex_to_gf2_polynomial("b"), 1));
+  expected.push_back(std::make_pair(hex_to_gf2_polynomial("d"), 6));
+  expected.push_back(std::make_pair(hex_to_gf2_polynomial("13"), 1));
+  expected.push_back(std::make_pair(make_xn(89) + make_xn(38) + make_xn(0), 2));
+  expected.push_back(std::make_pair(make_xn(127) + make_xn(1) + make_xn(0), 3));
+  gf2_polynomial f = make_xn(0);
+  for (const auto& e : expected)
+    f = f*power(e.first, (int)e.second);
+  for (auto method : {gf2_factor_automatic, gf2_factor_cantor_zassenhaus, gf2_factor_berlekamp}) {
+    auto F = factor(f, method);
+    TEST_EQ(expected.size(), F.size());
+    for (size_t i = 0; i < F.size() && i < expected.size(); ++i) {
+      TEST_ASSERT(F[i].first == expected[i].first);
+      TEST_EQ(expected[i].second, F[i].second);
+    }
+  }
+  TEST_EQ(0, factor(make_xn(0)).size());
+  auto F = factor(make_xn(70));
+  TEST_EQ(1, F.size());
+  TEST_EQ(70, F[0].second);
+  bool thrown = false;
+  try {
+    factor(gf2_polynomial());
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+
+  gf2_random_engine().seed(16);
+  for (int k = 0; k < 4; ++k) {
+    gf2_polynomial g = make_random_gf2_polynomial(150) * power(make_random_gf2_polynomial(40), 3);
+    if (is_zero(g))
+      continue;
+    auto G = factor(g);
+    gf2_polynomial p = make_xn(0);
+    for (size_t i = 0; i < G.size(); ++i) {
+      p = p*power(G[i].first, (int)G[i].second);
+      TEST_EQ(1, berlekamp_factorization(G[i].first).size());
+      if (i > 0)
+        TEST_ASSERT(less_by_degree(G[i-1].first, G[i].first));
+    }
+    TEST_ASSERT(p == g);
+  }
+}
+
+void test_random_engine() {
+  gf2_random_engine().seed(17);
+  gf2_polynomial a = make_random_gf2_polynomial(300);
+  gf2_random_engine().seed(17);
+  TEST_ASSERT(a == make_random_gf2_polynomial(300));
+  std::mt19937_64 rng(17);
+  TEST_ASSERT(a == make_random_gf2_polynomial(300, rng));
+  TEST_ASSERT(degree(make_random_gf2_polynomial(63, rng)) <= 63);
+  TEST_ASSERT(degree(make_random_gf2_polynomial(64, rng)) <= 64);
+}
+
+void test_thread_pool() {
+  gf2_thread_pool pool(4);
+  TEST_EQ(4, pool.size());
+  for (size_t n : {0, 1, 3, 1000}) {
+    std::vector<std::atomic<int>> hits(n);
+    for (auto& h : hits)
+      h = 0;
+    std::atomic<bool> bad_worker(false);
+    pool.parallel_for(n, [&](size_t i, unsigned worker) {
+      if (worker >= 4)
+        bad_worker = true;
+      // uneven work, so the workers with the cheap indices have to steal
+      volatile uint64_t x = 0;
+      for (size_t k = 0; k < (i < n/4 ? 20000 : 10); ++k)
+        x = x + k;
+      ++hits[i];
+    });
+    bool once = true;
+    for (auto& h : hits)
+      once = once && h == 1;
+    TEST_ASSERT(once);
+    TEST_ASSERT(!bad_worker);
+  }
+  bool thrown = false;
+  try {
+    pool.parallel_for(100, [](size_t i, unsigned) {
+      if (i == 37)
+        throw std::runtime_error("test");
+    });
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+  // the pool is still usable after an exception
+  std::atomic<size_t> sum(0);
+  pool.parallel_for(10, [&](size_t i, unsigned) { sum += i; });
+  TEST_EQ(45, sum.load());
+}
+
+void test_factor_batch() {
+  gf2_random_engine().seed(18);
+  std::vector<gf2_polynomial> polynomials;
+  for (int i = 0; i < 40; ++i)
+    polynomials.push_back(make_random_gf2_polynomial(20 + 10*(i%7)) * make_random_gf2_polynomial(5) + make_xn(90));
+  gf2_thread_pool pool(3);
+  auto result = factor_batch(polynomials, pool, 5);
+  TEST_EQ(polynomials.size(), result.size());
+  for (size_t i = 0; i < polynomials.size() && i < result.size(); ++i) {
+    auto expected = factor(polynomials[i]);
+    TEST_EQ(expected.size(), result[i].size());
+    TEST_ASSERT(expected == result[i]);
+  }
+  TEST_ASSERT(factor_batch(polynomials, 2, 9, gf2_factor_berlekamp) == result);
+
+  std::stringstream in, out;
+  in << "c\n\n73af\r\n" << gf2_polynomial_to_hex(make_xn(127) + make_xn(1) + make_xn(0)) << "\n7\n";
+  TEST_EQ(4, factor_stream(in, out, pool, 2));
+  std::string expected_output = "c: 2^2 3\n73af: 83 e5\n" + gf2_polynomial_to_hex(make_xn(127) + make_xn(1) + make_xn(0)) + ": " + gf2_polynomial_to_hex(make_xn(127) + make_xn(1) + make_xn(0)) + "\n7: 7\n";
+  TEST_ASSERT(out.str() == expected_output);
+
+  polynomials[17] = gf2_polynomial();
+  bool thrown = false;
+  try {
+    factor_batch(polynomials, pool);
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+}
+
+void test_equal_degree_factorization_parallel() {
+  gf2_thread_pool pool(4);
+  // x^256 + x is the product of all irreducible polynomials of degree 1, 2, 4 and 8
+  gf2_polynomial f = make_xn(256) + make_xn(1);
+  auto ddf = distinct_degree_factorization(f);
+  TEST_EQ(4, ddf.size());
+  const size_t counts[] = {2, 1, 3, 30};
+  for (size_t i = 0; i < ddf.size(); ++i) {
+    auto factors = equal_degree_factorization_parallel(ddf[i].first, ddf[i].second, pool, 3);
+    TEST_EQ(counts[i], factors.size());
+    gf2_polynomial p = make_xn(0);
+    for (size_t j = 0; j < factors.size(); ++j) {
+      TEST_EQ(ddf[i].second, degree(factors[j]));
+      p = p*factors[j];
+      if (j > 0)
+        TEST_ASSERT(less_by_degree(factors[j-1], factors[j]));
+    }
+    TEST_ASSERT(p == ddf[i].first);
+  }
+  auto F = factor_parallel(f, pool);
+  TEST_EQ(36, F.size());
+  TEST_ASSERT(F == factor(f));
+  gf2_polynomial g = power(f, 3) * (make_xn(127) + make_xn(1) + make_xn(0));
+  TEST_ASSERT(factor_parallel(g, pool, 11) == factor(g));
+  gf2_random_engine().seed(19);
+  for (int k = 0; k < 5; ++k) {
+    gf2_polynomial h = make_random_gf2_polynomial(300) * power(make_random_gf2_polynomial(30), 2);
+    if (!is_zero(h))
+      TEST_ASSERT(factor_parallel(h, pool, k) == factor(h));
+  }
+  gf2_thread_pool single(1);
+  TEST_ASSERT(factor_parallel(f, single) == factor(f));
+}
+
+void test_square() {
+  gf2_random_engine().seed(20);
+  for (uint64_t n : {0, 1, 31, 32, 63, 64, 65, 500}) {
+    gf2_polynomial a = make_random_gf2_polynomial(n);
+    TEST_ASSERT(square(a) == a*a);
+    TEST_ASSERT(sqrt(square(a)) == a);
+  }
+  TEST_ASSERT(is_zero(square(gf2_polynomial())));
+  TEST_EQ(0x5555555555555555ULL, gf2_spread_bits32(0xffffffffULL));
+  TEST_EQ(0x12345678ULL, gf2_compact_even_bits(gf2_spread_bits32(0x12345678ULL)));
+}
+
+void test_compose() {
+  gf2_random_engine().seed(21);
+  for (uint64_t n : {1, 10, 64, 200, 700}) {
+    gf2_polynomial f = make_random_gf2_polynomial(n-1) + make_xn(n);
+    gf2_modulus m = make_gf2_modulus(f);
+    gf2_polynomial a = make_random_gf2_polynomial(n + 30);
+    gf2_polynomial b = make_random_gf2_polynomial(n + 5);
+    // Horner evaluation of a at b
+    gf2_polynomial expected;
+    for (uint64_t i = degree(a) + 1; i-- > 0;) {
+      expected = mulmod(expected, b, m);
+      if (coefficient(a, i))
+        expected = expected + make_xn(0);
+    }
+    reduce(expected, m);
+    TEST_ASSERT(compose(a, b, m) == expected);
+    TEST_ASSERT(compose(a, make_xn(1), m) == a % f);
+    TEST_ASSERT(is_zero(compose(gf2_polynomial(), b, m)));
+  }
+}
+
+void test_trace_map() {
+  gf2_random_engine().seed(22);
+  for (uint64_t n : {20, 130, 600}) {
+    gf2_polynomial f = make_random_gf2_polynomial(n-1) + make_xn(n);
+    gf2_modulus m = make_gf2_modulus(f);
+    gf2_polynomial h = make_random_gf2_polynomial(n-1);
+    for (uint64_t d : {1, 2, 3, 7, 8, 64, 65, 100}) {
+      gf2_polynomial expected = h % f;
+      gf2_polynomial last = h % f;
+      for (uint64_t j = 1; j < d; ++j) {
+        last = mulmod(last, last, m);
+        expected = expected + last;
+      }
+      TEST_ASSERT(trace_map(h, d, m, gf2_trace_squaring) == expected);
+      TEST_ASSERT(trace_map(h, d, m, gf2_trace_composition) == expected);
+      TEST_ASSERT(trace_map(h, d, m) == expected);
+    }
+  }
+  // modulo an irreducible polynomial of degree d the trace lies in GF(2)
+  gf2_polynomial f = make_xn(127) + make_xn(1) + make_xn(0);
+  gf2_modulus m = make_gf2_modulus(f);
+  gf2_trace_context c = make_gf2_trace_context(127, m, gf2_trace_composition);
+  for (int i = 0; i < 5; ++i) {
+    gf2_polynomial t = trace_map(make_random_gf2_polynomial(126), c, m);
+    TEST_ASSERT(degree(t) == 0);
+  }
+  TEST_ASSERT(trace_map(make_xn(0), c, m) == make_xn(0));
+}
+
+void test_square_sqrt_kernels() {
+  std::mt19937_64 rng(23);
+  for (size_t n : {1, 2, 3, 17}) {
+    std::vector<uint64_t> a(n), r1(2*n), r2(2*n, 0), s1((n+1)/2), s2((n+1)/2);
+    for (auto& w : a)
+      w = rng();
+    gf2_words_square_portable(r1.data(), a.data(), n);
+    gf2_words_square(r2.data(), a.data(), n);
+    TEST_ASSERT(r1 == r2);
+#if defined(GF2_X86_INTRINSICS)
+    if (gf2_cpu().fast_pdep) {
+      gf2_words_square_bmi2(r2.data(), a.data(), n);
+      TEST_ASSERT(r1 == r2);
+      gf2_words_sqrt_bmi2(s2.data(), a.data(), n);
+      gf2_words_sqrt_portable(s1.data(), a.data(), n);
+      TEST_ASSERT(s1 == s2);
+    }
+#endif
+    // the square root undoes the squaring, also in place
+    gf2_words_sqrt(r1.data(), r1.data(), 2*n);
+    TEST_ASSERT(std::vector<uint64_t>(r1.begin(), r1.begin() + n) == a);
+  }
+  gf2_polynomial g = hex_to_gf2_polynomial("a466cfdc11");
+  TEST_ASSERT(power(g, 8) == square(square(square(g))));
+  TEST_ASSERT(sqrt(sqrt(power(g, 4))) == g);
+}
+
+void test_frobenius_x() {
+  gf2_random_engine().seed(24);
+  for (uint64_t n : {1, 40, 300}) {
+    gf2_modulus m = make_gf2_modulus(make_random_gf2_polynomial(n-1) + make_xn(n));
+    for (uint64_t k : {0, 1, 2, 5, 64, 301}) {
+      gf2_polynomial expected = frobenius(make_xn(1), k, m);
+      TEST_ASSERT(frobenius_x(k, m, gf2_trace_squaring) == expected);
+      TEST_ASSERT(frobenius_x(k, m, gf2_trace_composition) == expected);
+    }
+  }
+}
+
+void test_is_irreducible() {
+  const gf2_irreducibility_method methods[] = {gf2_irreducibility_automatic, gf2_irreducibility_rabin, gf2_irreducibility_ben_or};
+  std::vector<gf2_polynomial> irreducible;
+  for (const char* h : {"2", "3", "7", "b", "d", "13", "11b", "1000000000000001b"})
+    irreducible.push_back(hex_to_gf2_polynomial(h));
+  irreducible.push_back(make_xn(89) + make_xn(38) + make_xn(0));
+  irreducible.push_back(make_xn(127) + make_xn(1) + make_xn(0));
+  std::vector<gf2_polynomial> reducible;
+  reducible.push_back(gf2_polynomial());
+  reducible.push_back(make_xn(0));
+  reducible.push_back(make_xn(2));
+  reducible.push_back(hex_to_gf2_polynomial("5"));
+  reducible.push_back(hex_to_gf2_polynomial("13")*hex_to_gf2_polynomial("1f"));
+  // product of two irreducible factors of the same degree, which Ben-Or only finds at the last step
+  reducible.push_back((make_xn(89) + make_xn(38) + make_xn(0))*(make_xn(89) + make_xn(51) + make_xn(0)));
+  // x^(2^n) = x for all n/p steps of Rabin's test but one
+  reducible.push_back((make_xn(127) + make_xn(1) + make_xn(0))*hex_to_gf2_polynomial("b"));
+  for (auto method : methods) {
+    for (const auto& f : irreducible)
+      TEST_ASSERT(is_irreducible(f, method));
+    for (const auto& f : reducible)
+      TEST_ASSERT(!is_irreducible(f, method));
+  }
+  gf2_random_engine().seed(25);
+  const uint64_t ben_or = gf2_irreducibility_ben_or_degree();
+  gf2_irreducibility_ben_or_degree() = 2;
+  for (uint64_t n : {2, 3, 12, 30, 64, 96}) {
+    for (int k = 0; k < 20; ++k) {
+      gf2_polynomial f = make_random_gf2_polynomial(n-1) + make_xn(n);
+      auto F = factor(f);
+      const bool expected = F.size() == 1 && F[0].second == 1;
+      gf2_modulus m = make_gf2_modulus(f);
+      for (auto method : methods)
+        TEST_EQ(expected, is_irreducible(m, method));
+    }
+  }
+  gf2_irreducibility_ben_or_degree() = ben_or;
+  // Rabin's test with compositions
+  const double c = gf2_trace_composition_factor();
+  gf2_trace_composition_factor() = 0.0;
+  TEST_ASSERT(is_irreducible(make_xn(127) + make_xn(1) + make_xn(0), gf2_irreducibility_rabin));
+  TEST_ASSERT(!is_irreducible((make_xn(89) + make_xn(38) + make_xn(0))*(make_xn(89) + make_xn(51) + make_xn(0)), gf2_irreducibility_rabin));
+  gf2_trace_composition_factor() = c;
+}
+
+// evaluated by the compiler: x^64 + x^4 + x^3 + x + 1 is irreducible, so x is invertible modulo it
+constexpr gf2_poly_fixed<65> fixed_modulus = hex_to_gf2_poly_fixed<65>("1000000000000001b");
+static_assert(degree(fixed_modulus) == 64, "gf2_poly_fixed: degree");
+static_assert(degree(make_gf2_poly_fixed_xn<65>(63)*make_gf2_poly_fixed_xn<65>(63)) == 126, "gf2_poly_fixed: product");
+static_assert(mulmod(make_gf2_poly_fixed_xn<65>(63), make_gf2_poly_fixed_xn<65>(1), fixed_modulus) == make_gf2_poly_fixed<65>(0x1b), "gf2_poly_fixed: mulmod");
+static_assert(gcd(hex_to_gf2_poly_fixed<16>("13")*hex_to_gf2_poly_fixed<16>("7"), hex_to_gf2_poly_fixed<16>("13")*hex_to_gf2_poly_fixed<16>("b")) == make_gf2_poly_fixed<31>(0x13), "gf2_poly_fixed: gcd");
+static_assert(mulmod(make_gf2_poly_fixed_xn<65>(63), make_gf2_poly_fixed_xn<65>(1), make_gf2_modulus_fixed(fixed_modulus)) == make_gf2_poly_fixed<65>(0x1b), "gf2_poly_fixed: Barrett reduction");
+static_assert(hex_to_gf2_poly_fixed<16>("73af") % hex_to_gf2_poly_fixed<8>("83") == gf2_poly_fixed<8>(), "gf2_poly_fixed: remainder");
+
+void test_poly_fixed() {
+  gf2_random_engine().seed(28);
+  for (int k = 0; k < 50; ++k) {
+    gf2_polynomial a = make_random_gf2_polynomial(127);
+    gf2_polynomial b = make_random_gf2_polynomial(k < 25 ? 64 : 100);
+    auto fa = make_gf2_poly_fixed<128>(a);
+    auto fb = make_gf2_poly_fixed<101>(b);
+    TEST_ASSERT(to_gf2_polynomial(fa) == a);
+    TEST_ASSERT(to_gf2_polynomial(fa + make_gf2_poly_fixed<128>(b)) == a + b);
+    TEST_ASSERT(to_gf2_polynomial(fa*fb) == a*b);
+    TEST_EQ(degree(a*b), degree(fa*fb));
+    if (is_zero(b))
+      continue;
+    TEST_ASSERT(to_gf2_polynomial(fa % fb) == a % b);
+    TEST_ASSERT(to_gf2_polynomial(fa / fb) == a / b);
+    TEST_ASSERT(to_gf2_polynomial(gcd(fa, make_gf2_poly_fixed<128>(b))) == gcd(a, b));
+  }
+  // GHASH: the modulus x^128 + x^7 + x^2 + x + 1 needs 129 coefficients
+  const auto ghash = hex_to_gf2_poly_fixed<129>("100000000000000000000000000000087");
+  gf2_polynomial f = to_gf2_polynomial(ghash);
+  gf2_polynomial a = make_random_gf2_polynomial(127);
+  gf2_polynomial b = make_random_gf2_polynomial(127);
+  TEST_ASSERT(to_gf2_polynomial(mulmod(make_gf2_poly_fixed<129>(a), make_gf2_poly_fixed<129>(b), ghash)) == (a*b) % f);
+  TEST_ASSERT(to_gf2_polynomial(mulmod(make_gf2_poly_fixed<129>(a), make_gf2_poly_fixed<129>(b), make_gf2_modulus_fixed(ghash))) == (a*b) % f);
+  for (uint64_t n : {1, 2, 63, 64, 100}) {
+    gf2_polynomial g = make_random_gf2_polynomial(n-1) + make_xn(n);
+    const auto m = make_gf2_modulus_fixed(make_gf2_poly_fixed<101>(g));
+    for (int k = 0; k < 5; ++k) {
+      gf2_polynomial x = make_random_gf2_polynomial(n-1);
+      gf2_polynomial y = make_random_gf2_polynomial(n-1);
+      TEST_ASSERT(to_gf2_polynomial(mulmod(make_gf2_poly_fixed<101>(x), make_gf2_poly_fixed<101>(y), m)) == (x*y) % g);
+    }
+  }
+  TEST_ASSERT(gf2_poly_fixed_to_hex(hex_to_gf2_poly_fixed<16>("73af")) == "73af");
+  TEST_ASSERT(is_zero(gf2_poly_fixed<64>()));
+  TEST_EQ(0, degree(gf2_poly_fixed<64>()));
+  TEST_EQ(1, coefficient(make_gf2_poly_fixed<8>(0x80), 7));
+  TEST_EQ(0, coefficient(make_gf2_poly_fixed<8>(0x80), 8));
+  int thrown = 0;
+  try {
+    make_gf2_poly_fixed<64>(make_xn(64));
+  }
+  catch (std::runtime_error&) {
+    ++thrown;
+  }
+  try {
+    hex_to_gf2_poly_fixed<8>("1ff");
+  }
+  catch (std::runtime_error&) {
+    ++thrown;
+  }
+  try {
+    make_gf2_poly_fixed<8>(0x100);
+  }
+  catch (std::runtime_error&) {
+    ++thrown;
+  }
+  try {
+    make_gf2_poly_fixed<8>(0x13) % gf2_poly_fixed<8>();
+  }
+  catch (std::runtime_error&) {
+    ++thrown;
+  }
+  TEST_EQ(4, thrown);
+  TEST_ASSERT(hex_to_gf2_poly_fixed<16>("0073af") == make_gf2_poly_fixed<16>(0x73af));
+}
+
+template <size_t N>
+void check_gf2_field(const gf2_polynomial& f) {
+  const gf2_field<N> F = make_gf2_field<N>(f);
+  TEST_EQ(degree(f), F.m);
+  const auto one = make_gf2_poly_fixed<N>(1);
+  std::vector<gf2_poly_fixed<N>> elements;
+  for (int k = 0; k < 20; ++k) {
+    gf2_polynomial a = make_random_gf2_polynomial(F.m - 1);
+    gf2_polynomial b = make_random_gf2_polynomial(F.m - 1);
+    const auto fa = make_gf2_field_element(a, F);
+    const auto fb = make_gf2_field_element(b, F);
+    TEST_ASSERT(to_gf2_polynomial(mul(fa, fb, F)) == (a*b) % f);
+    TEST_ASSERT(to_gf2_polynomial(square(fa, F)) == (a*a) % f);
+    TEST_ASSERT(to_gf2_polynomial(power(fa, 1000003, F)) == powmod(a, 1000003, make_gf2_modulus(f)));
+    if (is_zero(a))
+      continue;
+    TEST_ASSERT(mul(fa, inverse(fa, F), F) == one);
+    TEST_ASSERT(to_gf2_polynomial(inverse(fa, F)) == modular_inverse(a, f));
+    elements.push_back(fa);
+  }
+  std::vector<gf2_poly_fixed<N>> inverses = elements;
+  batch_inverse(inverses, F);
+  for (size_t i = 0; i < elements.size(); ++i)
+    TEST_ASSERT(inverses[i] == inverse(elements[i], F));
+  TEST_ASSERT(power(gf2_poly_fixed<N>(), 0, F) == one);
+  TEST_ASSERT(is_zero(power(gf2_poly_fixed<N>(), 5, F)));
+  TEST_ASSERT(is_zero(mul(gf2_poly_fixed<N>(), one, F)));
+  bool thrown = false;
+  try {
+    inverse(gf2_poly_fixed<N>(), F);
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+}
+
+void test_gf2_field() {
+  gf2_random_engine().seed(29);
+  // the AES field, where x is not a generator, the inverse of 0x53 is 0xca
+  const auto aes = make_gf2_field<8>(hex_to_gf2_polynomial("11b"));
+  TEST_ASSERT(inverse(make_gf2_poly_fixed<8>(0x53), aes) == make_gf2_poly_fixed<8>(0xca));
+  TEST_ASSERT(mul(make_gf2_poly_fixed<8>(0x57), make_gf2_poly_fixed<8>(0x83), aes) == make_gf2_poly_fixed<8>(0xc1));
+  check_gf2_field<8>(hex_to_gf2_polynomial("11b"));
+  check_gf2_field<1>(hex_to_gf2_polynomial("3"));
+  check_gf2_field<64>(hex_to_gf2_polynomial("1002d"));
+  check_gf2_field<17>(make_xn(17) + make_xn(3) + make_xn(0));
+  check_gf2_field<64>(hex_to_gf2_polynomial("1000000000000001b"));
+  check_gf2_field<163>(make_xn(163) + make_xn(7) + make_xn(6) + make_xn(3) + make_xn(0));
+  // a dense modulus takes the Barrett reduction
+  gf2_search_options o;
+  o.degree = 100;
+  o.form = gf2_search_random;
+  o.seed = 29;
+  gf2_thread_pool pool(1);
+  uint64_t next = 0;
+  gf2_polynomial dense = search_polynomials(o, 1, next, pool)[0];
+  check_gf2_field<100>(dense);
+  check_gf2_field<128>(dense);
+  TEST_EQ(-1, make_gf2_field<128>(dense).sparse_count);
+  int thrown = 0;
+  try {
+    make_gf2_field<8>(hex_to_gf2_polynomial("13")*hex_to_gf2_polynomial("1f"));
+  }
+  catch (std::runtime_error&) {
+    ++thrown;
+  }
+  try {
+    make_gf2_field<8>(make_xn(9) + make_xn(1) + make_xn(0));
+  }
+  catch (std::runtime_error&) {
+    ++thrown;
+  }
+  TEST_EQ(2, thrown);
+}
+
+void test_mersenne_prime_factors() {
+  // every factor divides, and 2^n-1 is the product of their powers
+  for (uint64_t n = 1; n <= 128; ++n) {
+    std::vector<uint64_t> r = gf2_mersenne_number(n), q, rem;
+    for (const auto& p : gf2_mersenne_prime_factors(n)) {
+      q = gf2_natural_divide(r, p, rem);
+      TEST_ASSERT(rem.empty());
+      while (rem.empty()) {
+        r = q;
+        q = gf2_natural_divide(r, p, rem);
+      }
+    }
+    TEST_ASSERT(r == std::vector<uint64_t>(1, 1));
+  }
+  TEST_ASSERT(gf2_mersenne_prime_factors(127).size() == 1);
+  TEST_ASSERT(gf2_mersenne_prime_factors(127)[0] == gf2_mersenne_number(127));
+  TEST_ASSERT(gf2_natural_from_decimal("18446744073709551616") == std::vector<uint64_t>({0, 1}));
+  bool thrown = false;
+  try {
+    gf2_mersenne_prime_factors(129);
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+}
+
+void test_is_primitive() {
+  TEST_ASSERT(is_primitive(hex_to_gf2_polynomial("3")));
+  TEST_ASSERT(!is_primitive(hex_to_gf2_polynomial("2")));
+  TEST_ASSERT(is_primitive(hex_to_gf2_polynomial("13")));
+  // x^4 + x^3 + x^2 + x + 1 is irreducible, but x has order 5
+  TEST_ASSERT(!is_primitive(hex_to_gf2_polynomial("1f")));
+  TEST_ASSERT(is_primitive(hex_to_gf2_polynomial("1000000000000001b")));
+  // above 64 the exponents (2^n-1)/p take several words
+  const gf2_polynomial f127 = make_xn(127) + make_xn(1) + make_xn(0);
+  TEST_ASSERT(is_primitive(f127));
+  TEST_ASSERT(is_primitive(make_gf2_modulus(f127), gf2_mersenne_prime_factors(127)));
+  TEST_ASSERT(!is_primitive(f127 * make_xn(1) + make_xn(0)));
+  // decimating the sequence of a primitive f by 3 gives the minimal polynomial of a^3, irreducible of order (2^66-1)/3
+  const gf2_polynomial f66 = find_gf2_polynomial(66, gf2_search_pentanomial, gf2_search_primitive, 1);
+  TEST_ASSERT(is_primitive(f66));
+  const std::vector<uint8_t> c = gf2_polynomial_to_coefficients(reversal(f66, 66));
+  std::vector<uint8_t> s(3*200, 0);
+  s[0] = 1;
+  for (size_t i = 66; i < s.size(); ++i) {
+    for (size_t j = 1; j <= 66; ++j)
+      s[i] ^= c[j] & s[i-j];
+  }
+  gf2_berlekamp_massey bm;
+  for (size_t i = 0; i < s.size(); i += 3)
+    gf2_berlekamp_massey_push(bm, s[i] != 0);
+  const gf2_polynomial g66 = characteristic_polynomial(bm);
+  TEST_EQ(66, degree(g66));
+  TEST_ASSERT(is_irreducible(g66));
+  TEST_ASSERT(!is_primitive(g66));
+  bool thrown = false;
+  try {
+    is_primitive(make_xn(129) + make_xn(0));
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+  // a^e for a two word exponent against e = e1*2^64 + e0 composed from single word powers
+  std::mt19937_64 rng(16);
+  const gf2_modulus m = make_gf2_modulus(make_random_gf2_polynomial(100, rng) + make_xn(101));
+  const gf2_polynomial a = make_random_gf2_polynomial(90, rng);
+  const uint64_t e0 = rng(), e1 = rng() >> 3;
+  const gf2_polynomial high = powmod(powmod(powmod(a, e1, m), (uint64_t)1 << 32, m), (uint64_t)1 << 32, m);
+  TEST_ASSERT(powmod(a, std::vector<uint64_t>({e0, e1}), m) == mulmod(high, powmod(a, e0, m), m));
+  TEST_ASSERT(powmod(a, std::vector<uint64_t>({e0, 0}), m) == powmod(a, e0, m));
+  // the order of x found by brute force
+  for (uint64_t n = 2; n <= 10; ++n) {
+    for (uint64_t low = 1; low < ((uint64_t)1 << n); low += 2) {
+      gf2_polynomial f = make_xn(n) + make_gf2_polynomial_from_words(std::vector<uint64_t>(1, low));
+      gf2_modulus m = make_gf2_modulus(f);
+      gf2_polynomial h = make_xn(1);
+      uint64_t order = 1;
+      while (h != make_xn(0) && order < ((uint64_t)1 << n)) {
+        h = mulmod(h, make_xn(1), m);
+        ++order;
+      }
+      const bool expected = is_irreducible(f) && order == ((uint64_t)1 << n) - 1;
+      TEST_EQ(expected, is_primitive(f));
+    }
+  }
+}
+
+void test_search_polynomials() {
+  gf2_thread_pool pool(3);
+  gf2_thread_pool single(1);
+  gf2_search_options o;
+  o.degree = 8;
+  o.chunk_size = 5;
+  uint64_t next = 0;
+  // 30 irreducible and 16 primitive polynomials of degree 8
+  auto all = search_polynomials(o, 100, next, pool);
+  TEST_EQ(30, all.size());
+  TEST_EQ(gf2_search_candidate_count(o), next);
+  TEST_ASSERT(all[0] == hex_to_gf2_polynomial("11b"));
+  for (size_t i = 0; i < all.size(); ++i) {
+    TEST_ASSERT(is_irreducible(all[i]));
+    if (i > 0)
+      TEST_ASSERT(less_by_degree(all[i-1], all[i]));
+  }
+  o.property = gf2_search_primitive;
+  next = 0;
+  TEST_EQ(16, search_polynomials(o, 100, next, pool).size());
+  // resuming continues where the last search stopped, the hits do not depend on the number of threads
+  o.degree = 40;
+  o.property = gf2_search_irreducible;
+  o.form = gf2_search_pentanomial;
+  next = 0;
+  auto first = search_polynomials(o, 20, next, single);
+  next = 0;
+  auto part = search_polynomials(o, 7, next, pool);
+  auto rest = search_polynomials(o, 13, next, pool);
+  part.insert(part.end(), rest.begin(), rest.end());
+  TEST_ASSERT(part == first);
+  o.form = gf2_search_random;
+  o.seed = 26;
+  next = 0;
+  auto random = search_polynomials(o, 4, next, pool);
+  next = 0;
+  TEST_ASSERT(search_polynomials(o, 4, next, single) == random);
+  for (const auto& f : random) {
+    TEST_EQ(40, degree(f));
+    TEST_ASSERT(is_irreducible(f));
+  }
+  TEST_ASSERT(find_gf2_polynomial(163, gf2_search_pentanomial, gf2_search_irreducible, 2) == make_xn(163) + make_xn(7) + make_xn(6) + make_xn(3) + make_xn(0));
+  TEST_ASSERT(find_gf2_polynomial(127, gf2_search_trinomial, gf2_search_irreducible, 2) == make_xn(127) + make_xn(1) + make_xn(0));
+  TEST_ASSERT(find_gf2_polynomial(64, gf2_search_pentanomial, gf2_search_primitive, 2) == hex_to_gf2_polynomial("1000000000000001b"));
+  TEST_ASSERT(find_gf2_polynomial(127, gf2_search_trinomial, gf2_search_primitive, 2) == make_xn(127) + make_xn(1) + make_xn(0));
+  // the GCM polynomial
+  TEST_ASSERT(find_gf2_polynomial(128, gf2_search_pentanomial, gf2_search_primitive, 2) == make_xn(128) + make_xn(7) + make_xn(2) + make_xn(1) + make_xn(0));
+  TEST_ASSERT(find_gf2_polynomial(1) == hex_to_gf2_polynomial("3"));
+  // there is no irreducible trinomial of degree 8
+  bool thrown = false;
+  try {
+    find_gf2_polynomial(8, gf2_search_trinomial, gf2_search_irreducible, 2);
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+}
+
 } // namespace
 
 
 
 
+void test_in_place_arithmetic() {
+  auto& rng = gf2_random_engine();
+  rng.seed(20);
+  for (uint64_t n : {5, 63, 64, 200, 1500}) {
+    const gf2_polynomial a = make_random_gf2_polynomial(n);
+    const gf2_polynomial b = make_random_gf2_polynomial(n/2+1);
+    gf2_polynomial c = a;
+    c += b;
+    TEST_ASSERT(c == a + b);
+    c -= b;
+    TEST_ASSERT(c == a);
+    c += c;
+    TEST_ASSERT(is_zero(c));
+    c = a;
+    c *= b;
+    TEST_ASSERT(c == a*b);
+    c *= c;
+    TEST_ASSERT(c == square(a*b));
+    c %= b;
+    TEST_ASSERT(c == square(a*b) % b);
+    mul_into(c, a, b);
+    TEST_ASSERT(c == a*b);
+    c = b;
+    mul_into(c, a, c);
+    TEST_ASSERT(c == a*b);
+    c *= gf2_polynomial();
+    TEST_ASSERT(is_zero(c));
+
+    gf2_polynomial q, r;
+    divrem_into(q, r, a, b);
+    TEST_ASSERT(q == a/b);
+    TEST_ASSERT(r == a%b);
+    // the remainder in place of the dividend, and the quotient in place of it
+    r = a;
+    divrem_into(q, r, r, b);
+    TEST_ASSERT(q == a/b && r == a%b);
+    q = a;
+    divrem_into(q, r, q, b);
+    TEST_ASSERT(q == a/b && r == a%b);
+    divrem_into(q, r, b, make_xn(n+1));
+    TEST_ASSERT(is_zero(q) && r == b);
+
+    for (const gf2_polynomial& f : {make_random_gf2_polynomial(n) + make_xn(n+1), make_xn(n+1) + make_xn(n/2) + make_xn(0)}) {
+      const gf2_modulus m = make_gf2_modulus(f);
+      const gf2_polynomial x = a % f, y = b % f;
+      gf2_polynomial z;
+      mulmod_into(z, x, y, m);
+      TEST_ASSERT(z == (x*y) % f);
+      z = x;
+      mulmod_into(z, z, y, m);
+      TEST_ASSERT(z == (x*y) % f);
+      sqrmod_into(z, z, m);
+      TEST_ASSERT(z == square(x*y) % f);
+      sqrmod_into(z, x, m);
+      TEST_ASSERT(z == square(x) % f);
+    }
+
+    gf2_polynomial g = a*b, h = b*b;
+    gcd_in_place(g, h);
+    TEST_ASSERT(g == gcd(a*b, b*b));
+    TEST_ASSERT(is_zero((a*b) % g) && is_zero((b*b) % g));
+  }
+  gf2_polynomial q, r;
+  bool thrown = false;
+  try {
+    divrem_into(q, r, make_xn(3), gf2_polynomial());
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+}
+
+#if defined(GF2_ENABLE_STATS)
+void test_stats() {
+  gf2_reset_stats();
+  gf2_polynomial a = hex_to_gf2_polynomial("73af"), b = hex_to_gf2_polynomial("1b");
+  gf2_polynomial c = a*b;
+  gf2_stats s = gf2_collect_stats();
+  TEST_EQ(s.calls[gf2_stat_mul], 1);
+  TEST_EQ(s.size_max[gf2_stat_mul], degree(a));
+  TEST_EQ(s.calls[gf2_stat_allocation], 1);
+  // a warm buffer is reused
+  mul_into(c, b, a);
+  mul_into(c, a, b);
+  s = gf2_collect_stats();
+  TEST_EQ(s.calls[gf2_stat_mul], 3);
+  TEST_EQ(s.calls[gf2_stat_allocation], 1);
+
+  // the square free recursion of (a*b)^2 * a is timed once
+  gf2_reset_stats();
+  const gf2_polynomial f = square(a*b)*a;
+  auto factors = factor(f);
+  s = gf2_collect_stats();
+  TEST_ASSERT(!factors.empty());
+  TEST_EQ(s.stage_calls[gf2_stage_factor], 1);
+  TEST_EQ(s.stage_calls[gf2_stage_square_free], 1);
+  TEST_ASSERT(s.calls[gf2_stat_gcd] > 0);
+  TEST_ASSERT(s.calls[gf2_stat_divrem] > 0);
+
+  // four irreducibles of degree 8, each trial either splits a factor or fails
+  gf2_reset_stats();
+  gf2_random_engine().seed(22);
+  const char* irreducibles[] = {"11b", "11d", "12b", "165"};
+  gf2_polynomial g = make_xn(0);
+  for (const char* h : irreducibles)
+    g *= hex_to_gf2_polynomial(h);
+  TEST_EQ(equal_degree_factorization(g, 8).size(), 4);
+  s = gf2_collect_stats();
+  TEST_EQ(s.stage_calls[gf2_stage_equal_degree], 1);
+  TEST_ASSERT(s.calls[gf2_stat_edf_trial] >= 1);
+  TEST_ASSERT(s.calls[gf2_stat_edf_failed_split] < s.calls[gf2_stat_edf_trial]);
+  TEST_EQ(s.size_max[gf2_stat_edf_trial], 32);
+
+  // the counts of a thread survive its exit
+  gf2_reset_stats();
+  std::thread worker([&] {
+    gcd(a, b);
+    gcd(a, c);
+  });
+  worker.join();
+  gcd(b, c);
+  s = gf2_collect_stats();
+  TEST_EQ(s.calls[gf2_stat_gcd], 3);
+
+  const std::string json = gf2_stats_to_json(s);
+  TEST_ASSERT(json.find("\"gcd\": {\"calls\": 3,") != std::string::npos);
+  TEST_ASSERT(json.find("\"equal_degree\": {\"calls\": 0,") != std::string::npos);
+  const std::string text = gf2_stats_to_text(s);
+  TEST_ASSERT(text.find("edf_failed_split") != std::string::npos);
+  TEST_ASSERT(text.find("berlekamp") != std::string::npos);
+  gf2_reset_stats();
+  s = gf2_collect_stats();
+  TEST_EQ(s.calls[gf2_stat_gcd], 0);
+}
+#else
+// without GF2_ENABLE_STATS the macros are no-ops and the counters stay zero
+void test_stats_disabled() {
+  gf2_reset_stats();
+  gf2_polynomial a = hex_to_gf2_polynomial("73af"), b = hex_to_gf2_polynomial("1b");
+  gf2_polynomial c = a*b;
+  TEST_ASSERT(!is_zero(gcd(a, c)));
+  gf2_stats s = gf2_collect_stats();
+  TEST_EQ(s.calls[gf2_stat_gcd], 0);
+  TEST_EQ(s.calls[gf2_stat_mul], 0);
+}
+#endif
+
+void test_crc() {
+  const std::string check = "123456789";
+  const gf2_crc_method methods[] = {gf2_crc_automatic, gf2_crc_bytewise, gf2_crc_slicing_by_8, gf2_crc_slicing_by_16, gf2_crc_clmul};
+  for (auto m : methods) {
+    TEST_EQ(gf2_crc_compute(gf2_crc32(), check.data(), check.size(), m), 0xcbf43926ull);
+    TEST_EQ(gf2_crc_compute(gf2_crc32c(), check.data(), check.size(), m), 0xe3069283ull);
+    TEST_EQ(gf2_crc_compute(gf2_crc64_xz(), check.data(), check.size(), m), 0x995dc9bbdf1939faull);
+    TEST_EQ(gf2_crc_compute(gf2_crc64_ecma182(), check.data(), check.size(), m), 0x6c40df5f0b497347ull);
+    TEST_EQ(gf2_crc_compute(gf2_crc16_ccitt_false(), check.data(), check.size(), m), 0x29b1ull);
+  }
+  TEST_EQ(gf2_crc_initial(gf2_crc32()), 0);
+  // small widths, and an input reflection that differs from the output one
+  const gf2_crc crc5_usb = make_gf2_crc(hex_to_gf2_polynomial("25"), 0x1f, true, true, 0x1f);
+  const gf2_crc crc8_smbus = make_gf2_crc(hex_to_gf2_polynomial("107"), 0, false, false, 0);
+  const gf2_crc crc12_umts = make_gf2_crc(hex_to_gf2_polynomial("180f"), 0, false, true, 0);
+  TEST_EQ(gf2_crc_compute(crc5_usb, check.data(), check.size()), 0x19ull);
+  TEST_EQ(gf2_crc_compute(crc8_smbus, check.data(), check.size()), 0xf4ull);
+  TEST_EQ(gf2_crc_compute(crc12_umts, check.data(), check.size()), 0xdafull);
+
+  // all methods agree on every length around the folding block sizes and at odd offsets
+  std::mt19937_64 rng(23);
+  std::vector<uint8_t> data(5000);
+  for (auto& b : data)
+    b = (uint8_t)rng();
+  const gf2_crc* crcs[] = {&gf2_crc32(), &gf2_crc64_xz(), &gf2_crc64_ecma182(), &gf2_crc16_ccitt_false(), &crc5_usb, &crc12_umts};
+  for (const gf2_crc* c : crcs) {
+    for (size_t len : {0, 1, 15, 16, 63, 64, 65, 127, 128, 200, 255, 256, 1000, 4093}) {
+      const uint8_t* p = data.data() + 3;
+      const uint64_t expected = gf2_crc_compute(*c, p, len, gf2_crc_bytewise);
+      for (auto m : methods)
+        TEST_EQ(gf2_crc_compute(*c, p, len, m), expected);
+      // split anywhere, updated incrementally and combined
+      const size_t split = len/3;
+      const uint64_t head = gf2_crc_compute(*c, p, split);
+      TEST_EQ(gf2_crc_update(*c, head, p + split, len - split), expected);
+      const uint64_t tail = gf2_crc_compute(*c, p + split, len - split);
+      TEST_EQ(gf2_crc_combine(*c, head, tail, len - split), expected);
+    }
+  }
+  // the checksum m*x^w mod g, against the polynomial arithmetic
+  const gf2_crc plain = make_gf2_crc(hex_to_gf2_polynomial("142f0e1eba9ea3693"), 0, false, false, 0);
+  gf2_polynomial m;
+  for (size_t i = 0; i < 100; ++i)
+    m = mul_xn(m, 8) + make_gf2_polynomial_from_words(std::vector<uint64_t>(1, data[i]));
+  const gf2_polynomial r = mul_xn(m, 64) % plain.generator;
+  TEST_EQ(gf2_crc_compute(plain, data.data(), 100), is_zero(r) ? 0 : r.words[0]);
+
+  bool thrown = false;
+  try {
+    make_gf2_crc(make_xn(65) + make_xn(0), 0, false, false, 0);
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+}
+
+// the textbook bit by bit Berlekamp-Massey, returns the connection polynomial and sets the linear complexity
+gf2_polynomial berlekamp_massey_bitwise(const std::vector<uint8_t>& s, uint64_t& length) {
+  std::vector<uint8_t> c(s.size()+1, 0), b(s.size()+1, 0);
+  c[0] = b[0] = 1;
+  uint64_t l = 0, m = 1;
+  for (uint64_t n = 0; n < s.size(); ++n) {
+    uint8_t d = s[n];
+    for (uint64_t i = 1; i <= l; ++i)
+      d ^= c[i] & s[n-i];
+    if (d == 0) {
+      ++m;
+      continue;
+    }
+    const std::vector<uint8_t> t = c;
+    for (uint64_t i = 0; i + m < c.size(); ++i)
+      c[i+m] ^= b[i];
+    if (2*l <= n) {
+      l = n+1-l;
+      b = t;
+      m = 1;
+    }
+    else {
+      ++m;
+    }
+  }
+  length = l;
+  return make_gf2_polynomial(c);
+}
+
+// n bits of the LFSR with characteristic polynomial f from a state of deg(f) random bits
+std::vector<uint8_t> make_lfsr_sequence(const gf2_polynomial& f, uint64_t n, std::mt19937_64& rng) {
+  const uint64_t l = degree(f);
+  const std::vector<uint8_t> c = gf2_polynomial_to_coefficients(reversal(f, l));
+  std::vector<uint8_t> s(n);
+  for (uint64_t i = 0; i < n; ++i) {
+    if (i < l) {
+      s[i] = (uint8_t)(rng() & 1);
+      continue;
+    }
+    for (uint64_t j = 1; j <= l; ++j)
+      s[i] ^= c[j] & s[i-j];
+  }
+  return s;
+}
+
+std::vector<uint64_t> pack_bits(const std::vector<uint8_t>& s) {
+  std::vector<uint64_t> w((s.size()+63)/64, 0);
+  for (size_t i = 0; i < s.size(); ++i)
+    w[i/64] |= (uint64_t)s[i] << (i%64);
+  return w;
+}
+
+void test_berlekamp_massey() {
+  std::mt19937_64 rng(24);
+  // random sequences of every length around the word boundaries agree with the bitwise version
+  for (uint64_t n : {0, 1, 2, 5, 63, 64, 65, 127, 128, 129, 200, 500, 1000}) {
+    std::vector<uint8_t> s(n);
+    for (auto& bit : s)
+      bit = (uint8_t)(rng() & 1);
+    // a run of zeros followed by a one needs the whole length
+    if (n == 129) {
+      std::fill(s.begin(), s.end(), 0);
+      s.back() = 1;
+    }
+    uint64_t length = 0;
+    const gf2_polynomial expected = berlekamp_massey_bitwise(s, length);
+    gf2_berlekamp_massey bm;
+    gf2_berlekamp_massey_push(bm, pack_bits(s).data(), n);
+    TEST_EQ(connection_polynomial(bm), expected);
+    TEST_EQ(bm.length, length);
+    TEST_EQ(berlekamp_massey(pack_bits(s), n), expected);
+  }
+
+  // an LFSR of a primitive polynomial has exactly that characteristic polynomial, bit or word pushes
+  const gf2_polynomial f = make_xn(89) + make_xn(38) + make_xn(0);
+  const std::vector<uint8_t> s = make_lfsr_sequence(f, 1000, rng);
+  gf2_berlekamp_massey bm;
+  for (uint64_t i = 0; i < 300; ++i)
+    gf2_berlekamp_massey_push(bm, s[i] != 0);
+  const std::vector<uint64_t> w = pack_bits(std::vector<uint8_t>(s.begin() + 300, s.end()));
+  gf2_berlekamp_massey_push(bm, w.data(), 700);
+  TEST_EQ(bm.n, 1000);
+  TEST_EQ(bm.length, 89);
+  TEST_EQ(characteristic_polynomial(bm), f);
+  TEST_EQ(connection_polynomial(bm), reversal(f, 89));
+
+  // the sum of two LFSRs has the product of their polynomials, which factor splits back
+  const gf2_polynomial g = make_xn(31) + make_xn(3) + make_xn(0);
+  const std::vector<uint8_t> s1 = make_lfsr_sequence(f, 600, rng), s2 = make_lfsr_sequence(g, 600, rng);
+  std::vector<uint8_t> bytes(75, 0);
+  for (size_t i = 0; i < 600; ++i)
+    bytes[i/8] |= (uint8_t)((s1[i] ^ s2[i]) << (i%8));
+  gf2_berlekamp_massey sum;
+  gf2_berlekamp_massey_push_bytes(sum, bytes.data(), bytes.size());
+  TEST_EQ(sum.length, 120);
+  gf2_factorization factors = factor(characteristic_polynomial(sum));
+  std::sort(factors.begin(), factors.end(), [](const std::pair<gf2_polynomial, uint64_t>& a, const std::pair<gf2_polynomial, uint64_t>& b) {
+    return degree(a.first) < degree(b.first);
+  });
+  TEST_EQ(factors.size(), 2);
+  TEST_EQ(factors[0].first, g);
+  TEST_EQ(factors[1].first, f);
+
+  bool thrown = false;
+  try {
+    berlekamp_massey(std::vector<uint64_t>(1), 65);
+  }
+  catch (std::runtime_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+}
+
+bool corpus_reader_throws(const std::string& path) {
+  try {
+    gf2_corpus_reader reader(path);
+  }
+  catch (std::runtime_error&) {
+    return true;
+  }
+  return false;
+}
+
+void test_serialization() {
+  // hex parsing word by word: uppercase, leading zeros, and an invalid digit in the low or the high word
+  std::mt19937_64 rng(25);
+  const gf2_polynomial h = make_random_gf2_polynomial(1000, rng);
+  TEST_EQ(hex_to_gf2_polynomial(gf2_polynomial_to_hex(h)), h);
+  TEST_EQ(hex_to_gf2_polynomial("000000000000000000000000000A466CFDC"), hex_to_gf2_polynomial("a466cfdc"));
+  TEST_ASSERT(is_zero(hex_to_gf2_polynomial("0000")));
+  for (const char* bad : {"12345678901234567890x", "x12345678901234567890", "12 4"}) {
+    bool thrown = false;
+    try {
+      hex_to_gf2_polynomial(bad);
+    }
+    catch (std::runtime_error&) {
+      thrown = true;
+    }
+    TEST_ASSERT(thrown);
+  }
+
+  const std::string path = "gf2_serialization_test.corpus";
+  std::vector<gf2_polynomial> polys = {gf2_polynomial(), make_xn(0), make_xn(63), make_xn(64)};
+  for (uint64_t n : {1, 100, 1000, 5000})
+    polys.push_back(make_random_gf2_polynomial(n, rng));
+  const gf2_factorization f = factor(hex_to_gf2_polynomial("73af") * hex_to_gf2_polynomial("73af") * make_xn(1));
+  {
+    gf2_corpus_writer writer(path);
+    for (const auto& p : polys)
+      writer.write(p);
+    writer.write(f);
+    writer.write(factor(make_xn(0)));
+    TEST_EQ(writer.size(), polys.size() + f.size());
+  }
+  {
+    gf2_corpus_reader reader(path);
+    TEST_EQ(reader.size(), polys.size() + f.size());
+    TEST_EQ(reader.group_count(), polys.size() + 2);
+    for (size_t i = 0; i < polys.size(); ++i) {
+      const gf2_polynomial_view v = reader[i];
+      TEST_EQ(is_zero(v), is_zero(polys[i]));
+      TEST_EQ(degree(v), degree(polys[i]));
+      TEST_EQ(make_gf2_polynomial_from_view(v), polys[i]);
+      TEST_EQ(reader.multiplicity(i), 1);
+      TEST_EQ(reader.group_begin(i), i);
+    }
+    TEST_ASSERT(reader.factorization(polys.size()) == f);
+    TEST_ASSERT(reader.factorization(polys.size()+1).empty());
+    TEST_EQ(reader.group_begin(polys.size()+2), reader.size());
+  }
+
+  // a truncated file, a record whose top word lost its leading coefficient, and a missing file
+  std::string bytes;
+  {
+    std::ifstream in(path, std::ios::binary);
+    bytes.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), (std::streamsize)(bytes.size()-8));
+  }
+  TEST_ASSERT(corpus_reader_throws(path));
+  {
+    // record 2 is x^63: header at byte 16+16+(16+8), its word follows
+    std::string corrupt = bytes;
+    corrupt[16+16+24+16+7] = 0;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(corrupt.data(), (std::streamsize)corrupt.size());
+  }
+  TEST_ASSERT(corpus_reader_throws(path));
+  std::remove(path.c_str());
+  TEST_ASSERT(corpus_reader_throws(path));
+}
+
 void run_all_gf2_polynomial_tests() {
   test_construction();
   test_stream();
@@ -227,8 +1825,60 @@ void run_all_gf2_polynomial_tests() {
   test_hex_to_gf2_polynomial();
   test_sqrt();
   test_square_free_factorization();
+  test_square_free_factorization_layout();
   test_distinct_degree_factorization();
   test_equal_degree_factorization();
   test_equal_degree_factorization_2();
+  test_coefficients_roundtrip();
+  test_clmul64_portable();
+  test_multi_word_arithmetic();
+  test_hex_multi_word();
+  test_mul_kernels();
+  test_subquadratic_mul();
+  test_divide_by_x_plus_1();
+  test_cantor_basis();
+  test_fft_mul();
+  test_calibrate_mul_thresholds();
+  test_shifts_and_reversal();
+  test_newton_inverse();
+  test_newton_division();
+  test_modulus();
+  test_sparse_division();
+  test_distinct_degree_factorization_large_degrees();
+  test_distinct_degree_factorization_methods_agree();
+  test_half_gcd();
+  test_gcd_half_gcd();
+  test_extended_gcd();
+  test_modular_inverse();
+  test_gf2_matrix_echelon_form();
+  test_gf2_matrix_left_nullspace();
+  test_berlekamp_factorization();
+  test_power();
+  test_square_free_decomposition();
+  test_factor();
+  test_random_engine();
+  test_thread_pool();
+  test_factor_batch();
+  test_equal_degree_factorization_parallel();
+  test_square();
+  test_compose();
+  test_trace_map();
+  test_square_sqrt_kernels();
+  test_frobenius_x();
+  test_is_irreducible();
+  test_mersenne_prime_factors();
+  test_is_primitive();
+  test_search_polynomials();
+  test_poly_fixed();
+  test_gf2_field();
+  test_in_place_arithmetic();
+#if defined(GF2_ENABLE_STATS)
+  test_stats();
+#else
+  test_stats_disabled();
+#endif
+  test_crc();
+  test_berlekamp_massey();
+  test_serialization();
 
 }
@@ -0,0 +1,443 @@
+#ifndef GF2_SEARCH_H
+#define GF2_SEARCH_H
+
+#include "gf2_polynomial.h"
+#include "gf2_thread_pool.h"
+
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+/*
+Search for irreducible and primitive polynomials of a given degree n on a gf2_thread_pool.
+The candidates of a search are numbered, so a search can stop after a number of hits and be resumed later
+from the index it returns, and the hits come back in index order whatever the number of threads.
+Every candidate is first sieved with one gcd against the product of all irreducible polynomials of small degree,
+which rejects most reducible candidates, before the survivors go through Rabin's test.
+*/
+
+/*
+Natural numbers of several words, least significant word first, for the exponents (2^n-1)/p of the primitivity
+test above degree 64. Only what the test needs: 2^n-1, reading a decimal and a bitwise long division.
+*/
+inline std::vector<uint64_t> gf2_mersenne_number(uint64_t n) {
+  std::vector<uint64_t> r((size_t)(n/64), ~(uint64_t)0);
+  if (n & 63)
+    r.push_back(((uint64_t)1 << (n & 63)) - 1);
+  return r;
+}
+
+inline std::vector<uint64_t> gf2_natural_from_decimal(const char* s) {
+  std::vector<uint64_t> r;
+  for (; *s; ++s) {
+    // r = 10*r + digit, on 32 bit halves so that no product overflows
+    uint64_t carry = (uint64_t)(*s - '0');
+    for (auto& w : r) {
+      const uint64_t lo = (w & 0xffffffffULL)*10 + carry;
+      const uint64_t hi = (w >> 32)*10 + (lo >> 32);
+      w = (hi << 32) | (lo & 0xffffffffULL);
+      carry = hi >> 32;
+    }
+    if (carry)
+      r.push_back(carry);
+  }
+  return r;
+}
+
+// a / b, b not zero, with the remainder in rem
+inline std::vector<uint64_t> gf2_natural_divide(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b, std::vector<uint64_t>& rem) {
+  std::vector<uint64_t> q(a.size(), 0);
+  rem.assign(b.size()+1, 0);
+  auto rem_below_b = [&]() {
+    if (rem[b.size()] != 0)
+      return false;
+    for (size_t i = b.size(); i-- > 0;) {
+      if (rem[i] != b[i])
+        return rem[i] < b[i];
+    }
+    return false;
+  };
+  for (size_t bit = 64*a.size(); bit-- > 0;) {
+    // rem = 2*rem + bit of a, then subtract b if it fits
+    for (size_t i = rem.size(); i-- > 1;)
+      rem[i] = (rem[i] << 1) | (rem[i-1] >> 63);
+    rem[0] = (rem[0] << 1) | ((a[bit/64] >> (bit%64)) & 1);
+    if (rem_below_b())
+      continue;
+    uint64_t borrow = 0;
+    for (size_t i = 0; i < rem.size(); ++i) {
+      const uint64_t bi = i < b.size() ? b[i] : 0;
+      const uint64_t d = rem[i] - bi - borrow;
+      borrow = (rem[i] < bi || (rem[i] == bi && borrow)) ? 1 : 0;
+      rem[i] = d;
+    }
+    q[bit/64] |= (uint64_t)1 << (bit%64);
+  }
+  while (!q.empty() && q.back() == 0)
+    q.pop_back();
+  while (!rem.empty() && rem.back() == 0)
+    rem.pop_back();
+  return q;
+}
+
+// the distinct prime factors of 2^n - 1 for n <= 128, in increasing order, each as its words
+inline std::vector<std::vector<uint64_t>> gf2_mersenne_prime_factors(uint64_t n) {
+  static const uint64_t table[64][12] = {
+    {}, // 1
+    {3}, // 2
+    {7}, // 3
+    {3, 5}, // 4
+    {31}, // 5
+    {3, 7}, // 6
+    {127}, // 7
+    {3, 5, 17}, // 8
+    {7, 73}, // 9
+    {3, 11, 31}, // 10
+    {23, 89}, // 11
+    {3, 5, 7, 13}, // 12
+    {8191}, // 13
+    {3, 43, 127}, // 14
+    {7, 31, 151}, // 15
+    {3, 5, 17, 257}, // 16
+    {131071}, // 17
+    {3, 7, 19, 73}, // 18
+    {524287}, // 19
+    {3, 5, 11, 31, 41}, // 20
+    {7, 127, 337}, // 21
+    {3, 23, 89, 683}, // 22
+    {47, 178481}, // 23
+    {3, 5, 7, 13, 17, 241}, // 24
+    {31, 601, 1801}, // 25
+    {3, 2731, 8191}, // 26
+    {7, 73, 262657}, // 27
+    {3, 5, 29, 43, 113, 127}, // 28
+    {233, 1103, 2089}, // 29
+    {3, 7, 11, 31, 151, 331}, // 30
+    {2147483647}, // 31
+    {3, 5, 17, 257, 65537}, // 32
+    {7, 23, 89, 599479}, // 33
+    {3, 43691, 131071}, // 34
+    {31, 71, 127, 122921}, // 35
+    {3, 5, 7, 13, 19, 37, 73, 109}, // 36
+    {223, 616318177}, // 37
+    {3, 174763, 524287}, // 38
+    {7, 79, 8191, 121369}, // 39
+    {3, 5, 11, 17, 31, 41, 61681}, // 40
+    {13367, 164511353}, // 41
+    {3, 7, 43, 127, 337, 5419}, // 42
+    {431, 9719, 2099863}, // 43
+    {3, 5, 23, 89, 397, 683, 2113}, // 44
+    {7, 31, 73, 151, 631, 23311}, // 45
+    {3, 47, 178481, 2796203}, // 46
+    {2351, 4513, 13264529}, // 47
+    {3, 5, 7, 13, 17, 97, 241, 257, 673}, // 48
+    {127, 4432676798593}, // 49
+    {3, 11, 31, 251, 601, 1801, 4051}, // 50
+    {7, 103, 2143, 11119, 131071}, // 51
+    {3, 5, 53, 157, 1613, 2731, 8191}, // 52
+    {6361, 69431, 20394401}, // 53
+    {3, 7, 19, 73, 87211, 262657}, // 54
+    {23, 31, 89, 881, 3191, 201961}, // 55
+    {3, 5, 17, 29, 43, 113, 127, 15790321}, // 56
+    {7, 32377, 524287, 1212847}, // 57
+    {3, 59, 233, 1103, 2089, 3033169}, // 58
+    {179951, 3203431780337}, // 59
+    {3, 5, 7, 11, 13, 31, 41, 61, 151, 331, 1321}, // 60
+    {2305843009213693951}, // 61
+    {3, 715827883, 2147483647}, // 62
+    {7, 73, 127, 337, 92737, 649657}, // 63
+    {3, 5, 17, 257, 641, 65537, 6700417}, // 64
+  };
+  // above 64 several factors do not fit a word, they are written in decimal
+  static const char* const large_table[64][16] = {
+    {"31", "8191", "145295143558111"}, // 65
+    {"3", "7", "23", "67", "89", "683", "20857", "599479"}, // 66
+    {"193707721", "761838257287"}, // 67
+    {"3", "5", "137", "953", "26317", "43691", "131071"}, // 68
+    {"7", "47", "178481", "10052678938039"}, // 69
+    {"3", "11", "31", "43", "71", "127", "281", "86171", "122921"}, // 70
+    {"228479", "48544121", "212885833"}, // 71
+    {"3", "5", "7", "13", "17", "19", "37", "73", "109", "241", "433", "38737"}, // 72
+    {"439", "2298041", "9361973132609"}, // 73
+    {"3", "223", "1777", "25781083", "616318177"}, // 74
+    {"7", "31", "151", "601", "1801", "100801", "10567201"}, // 75
+    {"3", "5", "229", "457", "174763", "524287", "525313"}, // 76
+    {"23", "89", "127", "581283643249112959"}, // 77
+    {"3", "7", "79", "2731", "8191", "121369", "22366891"}, // 78
+    {"2687", "202029703", "1113491139767"}, // 79
+    {"3", "5", "11", "17", "31", "41", "257", "61681", "4278255361"}, // 80
+    {"7", "73", "2593", "71119", "262657", "97685839"}, // 81
+    {"3", "83", "13367", "164511353", "8831418697"}, // 82
+    {"167", "57912614113275649087721"}, // 83
+    {"3", "5", "7", "13", "29", "43", "113", "127", "337", "1429", "5419", "14449"}, // 84
+    {"31", "131071", "9520972806333758431"}, // 85
+    {"3", "431", "9719", "2099863", "2932031007403"}, // 86
+    {"7", "233", "1103", "2089", "4177", "9857737155463"}, // 87
+    {"3", "5", "17", "23", "89", "353", "397", "683", "2113", "2931542417"}, // 88
+    {"618970019642690137449562111"}, // 89
+    {"3", "7", "11", "19", "31", "73", "151", "331", "631", "23311", "18837001"}, // 90
+    {"127", "911", "8191", "112901153", "23140471537"}, // 91
+    {"3", "5", "47", "277", "1013", "1657", "30269", "178481", "2796203"}, // 92
+    {"7", "2147483647", "658812288653553079"}, // 93
+    {"3", "283", "2351", "4513", "13264529", "165768537521"}, // 94
+    {"31", "191", "524287", "420778751", "30327152671"}, // 95
+    {"3", "5", "7", "13", "17", "97", "193", "241", "257", "673", "65537", "22253377"}, // 96
+    {"11447", "13842607235828485645766393"}, // 97
+    {"3", "43", "127", "4363953127297", "4432676798593"}, // 98
+    {"7", "23", "73", "89", "199", "153649", "599479", "33057806959"}, // 99
+    {"3", "5", "11", "31", "41", "101", "251", "601", "1801", "4051", "8101", "268501"}, // 100
+    {"7432339208719", "341117531003194129"}, // 101
+    {"3", "7", "103", "307", "2143", "2857", "6529", "11119", "43691", "131071"}, // 102
+    {"2550183799", "3976656429941438590393"}, // 103
+    {"3", "5", "17", "53", "157", "1613", "2731", "8191", "858001", "308761441"}, // 104
+    {"7", "31", "71", "127", "151", "337", "29191", "106681", "122921", "152041"}, // 105
+    {"3", "107", "6361", "69431", "20394401", "28059810762433"}, // 106
+    {"162259276829213363391578010288127"}, // 107
+    {"3", "5", "7", "13", "19", "37", "73", "109", "87211", "246241", "262657", "279073"}, // 108
+    {"745988807", "870035986098720987332873"}, // 109
+    {"3", "11", "23", "31", "89", "683", "881", "2971", "3191", "201961", "48912491"}, // 110
+    {"7", "223", "321679", "26295457", "319020217", "616318177"}, // 111
+    {"3", "5", "17", "29", "43", "113", "127", "257", "5153", "15790321", "54410972897"}, // 112
+    {"3391", "23279", "65993", "1868569", "1066818132868207"}, // 113
+    {"3", "7", "571", "32377", "174763", "524287", "1212847", "160465489"}, // 114
+    {"31", "47", "14951", "178481", "4036961", "2646507710984041"}, // 115
+    {"3", "5", "59", "233", "1103", "2089", "3033169", "107367629", "536903681"}, // 116
+    {"7", "73", "79", "937", "6553", "8191", "86113", "121369", "7830118297"}, // 117
+    {"3", "2833", "37171", "179951", "1824726041", "3203431780337"}, // 118
+    {"127", "239", "20231", "131071", "62983048367", "131105292137"}, // 119
+    {"3", "5", "7", "11", "13", "17", "31", "41", "61", "151", "241", "331", "1321", "61681", "4562284561"}, // 120
+    {"23", "89", "727", "1786393878363164227858270210279"}, // 121
+    {"3", "768614336404564651", "2305843009213693951"}, // 122
+    {"7", "13367", "3887047", "164511353", "177722253954175633"}, // 123
+    {"3", "5", "5581", "8681", "49477", "384773", "715827883", "2147483647"}, // 124
+    {"31", "601", "1801", "269089806001", "4710883168879506001"}, // 125
+    {"3", "7", "19", "43", "73", "127", "337", "5419", "92737", "649657", "77158673929"}, // 126
+    {"170141183460469231731687303715884105727"}, // 127
+    {"3", "5", "17", "257", "641", "65537", "274177", "6700417", "67280421310721"}, // 128
+  };
+  if (n == 0 || n > 128)
+    throw std::runtime_error("gf2_mersenne_prime_factors: no factorization of 2^n-1 for this n!");
+  std::vector<std::vector<uint64_t>> factors;
+  if (n <= 64) {
+    for (const uint64_t* p = table[n-1]; *p != 0; ++p)
+      factors.push_back(std::vector<uint64_t>(1, *p));
+  } else {
+    for (const char* const* p = large_table[n-65]; *p != nullptr; ++p)
+      factors.push_back(gf2_natural_from_decimal(*p));
+  }
+  return factors;
+}
+
+/*
+Primitivity test: f of degree n is primitive if it is irreducible and x has order 2^n - 1 modulo f,
+that is x^((2^n-1)/p) != 1 mod f for every prime factor p of 2^n - 1, given in prime_factors as their words.
+The exponents are computed on several words, so any degree works given the factors.
+*/
+inline bool is_primitive(const gf2_modulus& m, const std::vector<std::vector<uint64_t>>& prime_factors) {
+  if (m.n == 0 || coefficient(m.f, 0) == 0 || !is_irreducible(m))
+    return false;
+  const std::vector<uint64_t> order = gf2_mersenne_number(m.n);
+  const gf2_polynomial x = make_xn(1);
+  const gf2_polynomial unit = make_xn(0);
+  std::vector<uint64_t> rem;
+  for (const auto& p : prime_factors) {
+    if (powmod(x, gf2_natural_divide(order, p, rem), m) == unit)
+      return false;
+  }
+  return true;
+}
+
+// with prime factors that fit a word
+inline bool is_primitive(const gf2_modulus& m, const std::vector<uint64_t>& prime_factors) {
+  std::vector<std::vector<uint64_t>> factors;
+  for (auto p : prime_factors)
+    factors.push_back(std::vector<uint64_t>(1, p));
+  return is_primitive(m, factors);
+}
+
+// with the shipped factorizations of 2^n - 1, degrees above 128 throw
+inline bool is_primitive(const gf2_polynomial& f) {
+  if (degree(f) > 128)
+    throw std::runtime_error("is_primitive: no factorization of 2^n-1 shipped for this degree!");
+  if (is_zero(f) || degree(f) == 0)
+    return false;
+  return is_primitive(make_gf2_modulus(f), gf2_mersenne_prime_factors(degree(f)));
+}
+
+// the product of all irreducible polynomials of degree at most k, the least common multiple of x^(2^d) + x for d <= k
+inline gf2_polynomial gf2_small_factor_product(uint64_t k) {
+  gf2_polynomial p = make_xn(0);
+  for (uint64_t d = 1; d <= k; ++d) {
+    const gf2_polynomial q = make_xn((uint64_t)1 << d) + make_xn(1);
+    p = p*(q/gcd(p, q));
+  }
+  return p;
+}
+
+// gf2_small_factor_product(k), built once per k and shared by all searches and their resumptions
+inline const gf2_polynomial& gf2_cached_small_factor_product(uint64_t k) {
+  static std::mutex mutex;
+  static std::map<uint64_t, gf2_polynomial> cache;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = cache.find(k);
+  if (it == cache.end())
+    it = cache.insert(std::make_pair(k, gf2_small_factor_product(k))).first;
+  return it->second;
+}
+
+enum gf2_search_form {
+  // x^n + g + 1 for all g of degree < n in increasing order, so the first hit is the smallest polynomial
+  gf2_search_dense,
+  // x^n + random bits + 1, candidate i is drawn from an engine seeded with the search seed and i
+  gf2_search_random,
+  // x^n + x^k + 1 for k = 1, ..., n-1
+  gf2_search_trinomial,
+  // x^n + x^a + x^b + x^c + 1 for n > a > b > c > 0, ordered by a, then b, then c
+  gf2_search_pentanomial
+};
+
+enum gf2_search_property {
+  gf2_search_irreducible,
+  gf2_search_primitive
+};
+
+struct gf2_search_options {
+  uint64_t degree = 0;
+  gf2_search_form form = gf2_search_dense;
+  gf2_search_property property = gf2_search_irreducible;
+  uint64_t seed = 0;
+  // candidates with an irreducible factor up to this degree are rejected by one gcd
+  uint64_t sieve_degree = 10;
+  // candidates tested in parallel between two checks for enough hits
+  size_t chunk_size = 1024;
+};
+
+// the number of candidates of a search, the maximum of uint64_t stands for no limit
+inline uint64_t gf2_search_candidate_count(const gf2_search_options& o) {
+  const uint64_t n = o.degree;
+  const uint64_t unlimited = std::numeric_limits<uint64_t>::max();
+  if (n == 0)
+    return 0;
+  switch (o.form) {
+  case gf2_search_dense:
+    return n <= 64 ? (uint64_t)1 << (n-1) : unlimited;
+  case gf2_search_random:
+    return unlimited;
+  case gf2_search_trinomial:
+    return n - 1;
+  case gf2_search_pentanomial:
+    return n < 4 ? 0 : (n-1)*(n-2)/2*(n-3)/3;
+  }
+  return 0;
+}
+
+// candidate i of a search
+inline gf2_polynomial make_gf2_search_candidate(const gf2_search_options& o, uint64_t i) {
+  const uint64_t n = o.degree;
+  gf2_polynomial f = make_xn(n);
+  switch (o.form) {
+  case gf2_search_dense:
+    f = f + make_gf2_polynomial_from_words(std::vector<uint64_t>(1, (i << 1) | 1));
+    break;
+  case gf2_search_random: {
+    std::mt19937_64 rng(o.seed ^ (i*0x9e3779b97f4a7c15ull));
+    f = f + make_random_gf2_polynomial(n-1, rng);
+    if (coefficient(f, 0) == 0)
+      f = f + make_xn(0);
+    break;
+  }
+  case gf2_search_trinomial:
+    f = f + make_xn(i+1) + make_xn(0);
+    break;
+  case gf2_search_pentanomial: {
+    // colex unranking of the 3-subset {c < b < a} of {1, ..., n-1}
+    auto binomial = [](uint64_t m, uint64_t k) {
+      uint64_t r = 1;
+      for (uint64_t j = 1; j <= k; ++j)
+        r = r*(m-k+j)/j;
+      return m < k ? 0 : r;
+    };
+    uint64_t e[3];
+    uint64_t r = i;
+    for (uint64_t k = 3; k > 0; --k) {
+      uint64_t m = k-1;
+      while (binomial(m+1, k) <= r)
+        ++m;
+      r -= binomial(m, k);
+      e[3-k] = m+1;
+    }
+    f = f + make_xn(e[0]) + make_xn(e[1]) + make_xn(e[2]) + make_xn(0);
+    break;
+  }
+  }
+  return f;
+}
+
+/*
+Tests the candidates from index next on and returns the first count that have the property, in index order.
+next is advanced past the last candidate returned, or to the end of the candidates if there are fewer hits,
+so calling again with the same next resumes the search.
+*/
+inline std::vector<gf2_polynomial> search_polynomials(const gf2_search_options& o, size_t count, uint64_t& next, gf2_thread_pool& pool) {
+  std::vector<gf2_polynomial> hits;
+  const uint64_t n = o.degree;
+  const uint64_t end = gf2_search_candidate_count(o);
+  if (count == 0 || next >= end)
+    return hits;
+  std::vector<std::vector<uint64_t>> prime_factors;
+  if (o.property == gf2_search_primitive)
+    prime_factors = gf2_mersenne_prime_factors(n);
+  // only factors up to degree n/2 prove f reducible
+  const gf2_polynomial& sieve = gf2_cached_small_factor_product(std::min(o.sieve_degree, n/2));
+  const size_t chunk_size = std::max<size_t>(1, o.chunk_size);
+  std::vector<gf2_polynomial> candidates;
+  std::vector<char> found;
+  while (hits.size() < count && next < end) {
+    const size_t size = (size_t)std::min<uint64_t>(chunk_size, end - next);
+    candidates.assign(size, gf2_polynomial());
+    found.assign(size, 0);
+    pool.parallel_for(size, [&](size_t j, unsigned) {
+      gf2_polynomial f = make_gf2_search_candidate(o, next + j);
+      uint64_t terms = 0;
+      for (auto w : f.words)
+        terms += gf2_popcount64(w);
+      if (n > 1 && (coefficient(f, 0) == 0 || terms % 2 == 0))
+        return;
+      gf2_modulus m = make_gf2_modulus(f);
+      gf2_polynomial r = sieve;
+      reduce(r, m);
+      if (degree(gcd(m.f, r)) != 0)
+        return;
+      if (o.property == gf2_search_primitive ? !is_primitive(m, prime_factors) : !is_irreducible(m, gf2_irreducibility_rabin))
+        return;
+      candidates[j] = std::move(f);
+      found[j] = 1;
+    });
+    size_t j = 0;
+    for (; j < size && hits.size() < count; ++j) {
+      if (found[j])
+        hits.push_back(std::move(candidates[j]));
+    }
+    next += j;
+  }
+  return hits;
+}
+
+// the first polynomial of degree n with the property in the order of the form, threads = 0 uses all hardware threads
+inline gf2_polynomial find_gf2_polynomial(uint64_t n, gf2_search_form form = gf2_search_dense, gf2_search_property property = gf2_search_irreducible, unsigned threads = 0) {
+  gf2_search_options o;
+  o.degree = n;
+  o.form = form;
+  o.property = property;
+  gf2_thread_pool pool(threads);
+  uint64_t next = 0;
+  auto hits = search_polynomials(o, 1, next, pool);
+  if (hits.empty())
+    throw std::runtime_error("find_gf2_polynomial: no polynomial of this form!");
+  return hits[0];
+}
+
+#endif
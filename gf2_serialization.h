@@ -0,0 +1,312 @@
+#ifndef GF2_SERIALIZATION_H
+#define GF2_SERIALIZATION_H
+
+#include "gf2_polynomial.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+A binary corpus of polynomials, all fields little endian 64 bit words:
+
+  header   magic "gf2corp\0", version
+  records  per record: number of coefficients (deg+1, 0 for the zero polynomial), multiplicity,
+           then the packed words exactly as in gf2_polynomial::words
+  index    the byte offset of every record, then the first record of every group
+  trailer  number of records, number of groups, byte offset of the index, magic
+
+A group is one polynomial with multiplicity 1, or the factors of one factorization with their multiplicities.
+The index sits at the end so that the writer can stream records without knowing their number in advance.
+Because every field is a word and every record starts on a word, the mapped file can be read in place:
+gf2_corpus_reader hands out views that point into the mapping, no parsing and no copy.
+*/
+const uint64_t gf2_corpus_magic = 0x0070726f63326667ull;
+const uint64_t gf2_corpus_version = 1;
+
+inline bool gf2_little_endian() {
+  const uint16_t one = 1;
+  uint8_t low;
+  std::memcpy(&low, &one, 1);
+  return low == 1;
+}
+
+// the words of a polynomial stored elsewhere, valid as long as the storage
+struct gf2_polynomial_view {
+  const uint64_t* words = nullptr;
+  size_t size = 0;
+  uint64_t deg = 0;
+};
+
+inline bool is_zero(const gf2_polynomial_view& v) {
+  return v.size == 0;
+}
+
+inline uint64_t degree(const gf2_polynomial_view& v) {
+  return v.deg;
+}
+
+inline gf2_polynomial make_gf2_polynomial_from_view(const gf2_polynomial_view& v) {
+  gf2_polynomial p;
+  p.words.assign(v.words, v.words + v.size);
+  p.deg = v.deg;
+  return p;
+}
+
+/*
+Streams records to a file, the index is kept in memory (16 bytes per record and group) and written by close.
+The file is a valid corpus only once close has run, the destructor calls it but cannot report an error.
+*/
+class gf2_corpus_writer {
+  public:
+    explicit gf2_corpus_writer(const std::string& path) : out(path, std::ios::binary | std::ios::trunc) {
+      if (!gf2_little_endian())
+        throw std::runtime_error("gf2_corpus_writer: only little endian hosts are supported!");
+      if (!out)
+        throw std::runtime_error("gf2_corpus_writer: cannot open " + path + "!");
+      const uint64_t header[2] = {gf2_corpus_magic, gf2_corpus_version};
+      put(header, 2);
+    }
+
+    ~gf2_corpus_writer() {
+      if (!closed) {
+        try {
+          close();
+        }
+        catch (...) {
+        }
+      }
+    }
+
+    gf2_corpus_writer(const gf2_corpus_writer&) = delete;
+    gf2_corpus_writer& operator = (const gf2_corpus_writer&) = delete;
+
+    // appends p as a group of its own
+    void write(const gf2_polynomial& p) {
+      groups.push_back(records.size());
+      put_record(p, 1);
+    }
+
+    // appends the factors of one factorization, with their multiplicities, as one group
+    void write(const gf2_factorization& f) {
+      groups.push_back(records.size());
+      for (const auto& factor : f)
+        put_record(factor.first, factor.second);
+    }
+
+    size_t size() const {
+      return records.size();
+    }
+
+    void close() {
+      if (closed)
+        return;
+      closed = true;
+      const uint64_t index = position;
+      put(records.data(), records.size());
+      put(groups.data(), groups.size());
+      const uint64_t trailer[4] = {records.size(), groups.size(), index, gf2_corpus_magic};
+      put(trailer, 4);
+      out.close();
+      if (!out)
+        throw std::runtime_error("gf2_corpus_writer: write failed!");
+    }
+
+  private:
+    std::ofstream out;
+    uint64_t position = 0;
+    std::vector<uint64_t> records;
+    std::vector<uint64_t> groups;
+    bool closed = false;
+
+    void put(const uint64_t* w, size_t n) {
+      out.write((const char*)w, (std::streamsize)(8*n));
+      if (!out)
+        throw std::runtime_error("gf2_corpus_writer: write failed!");
+      position += 8*(uint64_t)n;
+    }
+
+    void put_record(const gf2_polynomial& p, uint64_t multiplicity) {
+      records.push_back(position);
+      const uint64_t header[2] = {is_zero(p) ? 0 : p.deg+1, multiplicity};
+      put(header, 2);
+      put(p.words.data(), p.words.size());
+    }
+};
+
+/*
+Maps a corpus read only and checks its index once, after which every record is a view into the mapping.
+The views are valid as long as the reader.
+*/
+class gf2_corpus_reader {
+  public:
+    explicit gf2_corpus_reader(const std::string& path) {
+      if (!gf2_little_endian())
+        throw std::runtime_error("gf2_corpus_reader: only little endian hosts are supported!");
+      map(path);
+      try {
+        check();
+      }
+      catch (...) {
+        unmap();
+        throw;
+      }
+    }
+
+    ~gf2_corpus_reader() {
+      unmap();
+    }
+
+    gf2_corpus_reader(const gf2_corpus_reader&) = delete;
+    gf2_corpus_reader& operator = (const gf2_corpus_reader&) = delete;
+
+    // number of records
+    size_t size() const {
+      return record_count;
+    }
+
+    size_t group_count() const {
+      return groups;
+    }
+
+    gf2_polynomial_view operator[](size_t i) const {
+      const uint64_t* r = words + records[i]/8;
+      gf2_polynomial_view v;
+      v.words = r + 2;
+      v.size = (size_t)((r[0]+63)/64);
+      v.deg = r[0] ? r[0]-1 : 0;
+      return v;
+    }
+
+    uint64_t multiplicity(size_t i) const {
+      return words[records[i]/8 + 1];
+    }
+
+    // the records of group g are [group_begin(g), group_begin(g+1)), group_begin(group_count()) is size()
+    size_t group_begin(size_t g) const {
+      return g < groups ? (size_t)group_starts[g] : record_count;
+    }
+
+    gf2_factorization factorization(size_t g) const {
+      gf2_factorization f;
+      for (size_t i = group_begin(g); i < group_begin(g+1); ++i)
+        f.emplace_back(make_gf2_polynomial_from_view((*this)[i]), multiplicity(i));
+      return f;
+    }
+
+  private:
+    const uint64_t* words = nullptr;
+    uint64_t bytes = 0;
+    const uint64_t* records = nullptr;
+    const uint64_t* group_starts = nullptr;
+    size_t record_count = 0;
+    size_t groups = 0;
+#if defined(_WIN32)
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+
+    void map(const std::string& path) {
+#if defined(_WIN32)
+      file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+      if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("gf2_corpus_reader: cannot open " + path + "!");
+      LARGE_INTEGER size;
+      if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        unmap();
+        throw std::runtime_error("gf2_corpus_reader: " + path + " is not a polynomial corpus!");
+      }
+      bytes = (uint64_t)size.QuadPart;
+      mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping)
+        words = (const uint64_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if (!words) {
+        unmap();
+        throw std::runtime_error("gf2_corpus_reader: cannot map " + path + "!");
+      }
+#else
+      const int fd = ::open(path.c_str(), O_RDONLY);
+      if (fd < 0)
+        throw std::runtime_error("gf2_corpus_reader: cannot open " + path + "!");
+      struct stat st;
+      if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        throw std::runtime_error("gf2_corpus_reader: " + path + " is not a polynomial corpus!");
+      }
+      bytes = (uint64_t)st.st_size;
+      void* p = mmap(nullptr, (size_t)bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+      ::close(fd);
+      if (p == MAP_FAILED)
+        throw std::runtime_error("gf2_corpus_reader: cannot map " + path + "!");
+      words = (const uint64_t*)p;
+#endif
+    }
+
+    void unmap() {
+#if defined(_WIN32)
+      if (words)
+        UnmapViewOfFile(words);
+      if (mapping)
+        CloseHandle(mapping);
+      if (file != INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+      mapping = nullptr;
+      file = INVALID_HANDLE_VALUE;
+#else
+      if (words)
+        munmap((void*)words, (size_t)bytes);
+#endif
+      words = nullptr;
+    }
+
+    // every offset and length is checked here, so that the views never leave the mapping
+    void check() {
+      const uint64_t n = bytes/8;
+      if (bytes % 8 != 0 || n < 6 || words[0] != gf2_corpus_magic || words[n-1] != gf2_corpus_magic)
+        throw std::runtime_error("gf2_corpus_reader: not a polynomial corpus!");
+      if (words[1] != gf2_corpus_version)
+        throw std::runtime_error("gf2_corpus_reader: unsupported corpus version!");
+      const uint64_t nr = words[n-4], ng = words[n-3], index = words[n-2];
+      if (index % 8 != 0 || index < 16 || index/8 > n-4 || nr > n || ng > n || index/8 + nr + ng != n-4)
+        throw std::runtime_error("gf2_corpus_reader: corrupt index!");
+      records = words + index/8;
+      group_starts = records + nr;
+      record_count = (size_t)nr;
+      groups = (size_t)ng;
+      for (size_t i = 0; i < record_count; ++i) {
+        const uint64_t r = records[i];
+        if (r % 8 != 0 || r < 16 || r/8 + 2 > index/8)
+          throw std::runtime_error("gf2_corpus_reader: corrupt index!");
+        const uint64_t coefficients = words[r/8];
+        const uint64_t size = coefficients/64 + ((coefficients & 63) != 0);
+        if (size > index/8 - r/8 - 2)
+          throw std::runtime_error("gf2_corpus_reader: corrupt record!");
+        // normalized words: the top coefficient is bit deg of the last word, nothing above it
+        if (size && (words[r/8 + 1 + size] >> ((coefficients-1) & 63)) != 1)
+          throw std::runtime_error("gf2_corpus_reader: corrupt record!");
+      }
+      // groups can be empty, the factorization of a constant has no factors
+      for (size_t g = 0; g < groups; ++g) {
+        if (group_starts[g] > nr || (g == 0 ? group_starts[g] != 0 : group_starts[g] < group_starts[g-1]))
+          throw std::runtime_error("gf2_corpus_reader: corrupt index!");
+      }
+      if (record_count && !groups)
+        throw std::runtime_error("gf2_corpus_reader: corrupt index!");
+    }
+};
+
+#endif
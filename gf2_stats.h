@@ -0,0 +1,249 @@
+#ifndef GF2_STATS_H
+#define GF2_STATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+Counters and stage timers for the arithmetic and the factorization pipeline.
+They are compiled in only with GF2_ENABLE_STATS defined, otherwise the GF2_STAT macros expand to nothing.
+Every thread counts into its own block with relaxed atomics, so there is no contention and no locked instruction
+on the hot path. gf2_collect_stats sums the blocks of the live threads and of the threads that have exited.
+Each counter has a number of calls plus the sum and maximum of a size: the degree of the largest operand for the
+operations, the number of words for the allocations.
+*/
+enum gf2_stat {
+  gf2_stat_mul,
+  gf2_stat_square,
+  gf2_stat_divrem,
+  gf2_stat_mulmod,
+  gf2_stat_sqrmod,
+  gf2_stat_gcd,
+  gf2_stat_half_gcd,
+  gf2_stat_allocation,
+  gf2_stat_edf_trial,
+  gf2_stat_edf_failed_split,
+  gf2_stat_count
+};
+
+// stages of factor, nested calls of the same stage are timed once
+enum gf2_stage {
+  gf2_stage_factor,
+  gf2_stage_square_free,
+  gf2_stage_distinct_degree,
+  gf2_stage_equal_degree,
+  gf2_stage_berlekamp,
+  gf2_stage_count
+};
+
+inline const char* gf2_stat_name(gf2_stat s) {
+  static const char* names[gf2_stat_count] = {"mul", "square", "divrem", "mulmod", "sqrmod", "gcd", "half_gcd",
+    "allocation", "edf_trial", "edf_failed_split"};
+  return names[s];
+}
+
+inline const char* gf2_stage_name(gf2_stage s) {
+  static const char* names[gf2_stage_count] = {"factor", "square_free", "distinct_degree", "equal_degree", "berlekamp"};
+  return names[s];
+}
+
+// a snapshot of all counters
+struct gf2_stats {
+  uint64_t calls[gf2_stat_count] = {};
+  uint64_t size_sum[gf2_stat_count] = {};
+  uint64_t size_max[gf2_stat_count] = {};
+  uint64_t stage_calls[gf2_stage_count] = {};
+  uint64_t stage_ns[gf2_stage_count] = {};
+};
+
+// the counters of one thread, only that thread writes them
+struct gf2_stats_block {
+  std::atomic<uint64_t> calls[gf2_stat_count];
+  std::atomic<uint64_t> size_sum[gf2_stat_count];
+  std::atomic<uint64_t> size_max[gf2_stat_count];
+  std::atomic<uint64_t> stage_calls[gf2_stage_count];
+  std::atomic<uint64_t> stage_ns[gf2_stage_count];
+  unsigned depth[gf2_stage_count];
+};
+
+inline void gf2_stats_clear(gf2_stats_block& b) {
+  for (int i = 0; i < gf2_stat_count; ++i) {
+    b.calls[i].store(0, std::memory_order_relaxed);
+    b.size_sum[i].store(0, std::memory_order_relaxed);
+    b.size_max[i].store(0, std::memory_order_relaxed);
+  }
+  for (int i = 0; i < gf2_stage_count; ++i) {
+    b.stage_calls[i].store(0, std::memory_order_relaxed);
+    b.stage_ns[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+inline void gf2_stats_add(gf2_stats& s, const gf2_stats_block& b) {
+  for (int i = 0; i < gf2_stat_count; ++i) {
+    s.calls[i] += b.calls[i].load(std::memory_order_relaxed);
+    s.size_sum[i] += b.size_sum[i].load(std::memory_order_relaxed);
+    s.size_max[i] = std::max(s.size_max[i], b.size_max[i].load(std::memory_order_relaxed));
+  }
+  for (int i = 0; i < gf2_stage_count; ++i) {
+    s.stage_calls[i] += b.stage_calls[i].load(std::memory_order_relaxed);
+    s.stage_ns[i] += b.stage_ns[i].load(std::memory_order_relaxed);
+  }
+}
+
+// the blocks of the live threads and the sum of the blocks of the threads that have exited
+struct gf2_stats_registry {
+  std::mutex mutex;
+  std::vector<gf2_stats_block*> live;
+  gf2_stats retired;
+};
+
+inline gf2_stats_registry& gf2_stats_registry_instance() {
+  static gf2_stats_registry r;
+  return r;
+}
+
+// registers the block of a thread on its first count and folds it into the retired sum when the thread exits
+struct gf2_stats_thread {
+  gf2_stats_block block;
+  gf2_stats_thread() {
+    gf2_stats_clear(block);
+    for (auto& d : block.depth)
+      d = 0;
+    gf2_stats_registry& r = gf2_stats_registry_instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.live.push_back(&block);
+  }
+  ~gf2_stats_thread() {
+    gf2_stats_registry& r = gf2_stats_registry_instance();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    gf2_stats_add(r.retired, block);
+    for (size_t i = 0; i < r.live.size(); ++i) {
+      if (r.live[i] == &block) {
+        r.live[i] = r.live.back();
+        r.live.pop_back();
+        break;
+      }
+    }
+  }
+  gf2_stats_thread(const gf2_stats_thread&) = delete;
+  gf2_stats_thread& operator=(const gf2_stats_thread&) = delete;
+};
+
+inline gf2_stats_block& gf2_thread_stats() {
+  static thread_local gf2_stats_thread t;
+  return t.block;
+}
+
+// only the owning thread writes, so a relaxed load and store replace the locked read-modify-write
+inline void gf2_stats_bump(std::atomic<uint64_t>& c, uint64_t v) {
+  c.store(c.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+}
+
+inline void gf2_stats_record(gf2_stat s, uint64_t size) {
+  gf2_stats_block& b = gf2_thread_stats();
+  gf2_stats_bump(b.calls[s], 1);
+  gf2_stats_bump(b.size_sum[s], size);
+  if (size > b.size_max[s].load(std::memory_order_relaxed))
+    b.size_max[s].store(size, std::memory_order_relaxed);
+}
+
+// times a stage from construction to destruction, unless the thread is already inside that stage
+class gf2_stage_timer {
+public:
+  explicit gf2_stage_timer(gf2_stage s) : stage(s), block(gf2_thread_stats()), outermost(block.depth[s]++ == 0) {
+    if (outermost)
+      start = std::chrono::steady_clock::now();
+  }
+  ~gf2_stage_timer() {
+    --block.depth[stage];
+    if (!outermost)
+      return;
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    gf2_stats_bump(block.stage_calls[stage], 1);
+    gf2_stats_bump(block.stage_ns[stage], (uint64_t)ns);
+  }
+  gf2_stage_timer(const gf2_stage_timer&) = delete;
+  gf2_stage_timer& operator=(const gf2_stage_timer&) = delete;
+private:
+  gf2_stage stage;
+  gf2_stats_block& block;
+  bool outermost;
+  std::chrono::steady_clock::time_point start;
+};
+
+#if defined(GF2_ENABLE_STATS)
+#define GF2_STAT(stat, size) gf2_stats_record(stat, (uint64_t)(size))
+// counts an allocation if words has to grow to n words
+#define GF2_STAT_GROW(words, n) ((size_t)(n) > (words).capacity() ? gf2_stats_record(gf2_stat_allocation, (uint64_t)(n)) : (void)0)
+#define GF2_STAT_TIMER(stage) gf2_stage_timer gf2_stage_timer_##stage(stage)
+#else
+#define GF2_STAT(stat, size) ((void)0)
+#define GF2_STAT_GROW(words, n) ((void)0)
+#define GF2_STAT_TIMER(stage) ((void)0)
+#endif
+
+// the sum over all threads, the counts of other threads running at the same time may be a little behind
+inline gf2_stats gf2_collect_stats() {
+  gf2_stats_registry& r = gf2_stats_registry_instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  gf2_stats s = r.retired;
+  for (const gf2_stats_block* b : r.live)
+    gf2_stats_add(s, *b);
+  return s;
+}
+
+// counts made by other threads while the reset runs may survive it
+inline void gf2_reset_stats() {
+  gf2_stats_registry& r = gf2_stats_registry_instance();
+  std::lock_guard<std::mutex> lock(r.mutex);
+  r.retired = gf2_stats();
+  for (gf2_stats_block* b : r.live)
+    gf2_stats_clear(*b);
+}
+
+inline std::string gf2_stats_to_json(const gf2_stats& s) {
+  std::string r = "{\n  \"counters\": {";
+  char line[256];
+  for (int i = 0; i < gf2_stat_count; ++i) {
+    std::snprintf(line, sizeof(line), "%s\n    \"%s\": {\"calls\": %llu, \"size_sum\": %llu, \"size_max\": %llu}", i ? "," : "",
+      gf2_stat_name((gf2_stat)i), (unsigned long long)s.calls[i], (unsigned long long)s.size_sum[i], (unsigned long long)s.size_max[i]);
+    r += line;
+  }
+  r += "\n  },\n  \"stages\": {";
+  for (int i = 0; i < gf2_stage_count; ++i) {
+    std::snprintf(line, sizeof(line), "%s\n    \"%s\": {\"calls\": %llu, \"seconds\": %.9f}", i ? "," : "",
+      gf2_stage_name((gf2_stage)i), (unsigned long long)s.stage_calls[i], 1e-9*(double)s.stage_ns[i]);
+    r += line;
+  }
+  r += "\n  }\n}\n";
+  return r;
+}
+
+inline std::string gf2_stats_to_text(const gf2_stats& s) {
+  std::string r;
+  char line[256];
+  std::snprintf(line, sizeof(line), "%-18s %14s %14s %14s\n", "counter", "calls", "mean size", "max size");
+  r += line;
+  for (int i = 0; i < gf2_stat_count; ++i) {
+    const double mean = s.calls[i] ? (double)s.size_sum[i]/(double)s.calls[i] : 0.0;
+    std::snprintf(line, sizeof(line), "%-18s %14llu %14.1f %14llu\n", gf2_stat_name((gf2_stat)i),
+      (unsigned long long)s.calls[i], mean, (unsigned long long)s.size_max[i]);
+    r += line;
+  }
+  std::snprintf(line, sizeof(line), "%-18s %14s %14s\n", "stage", "calls", "seconds");
+  r += line;
+  for (int i = 0; i < gf2_stage_count; ++i) {
+    std::snprintf(line, sizeof(line), "%-18s %14llu %14.6f\n", gf2_stage_name((gf2_stage)i),
+      (unsigned long long)s.stage_calls[i], 1e-9*(double)s.stage_ns[i]);
+    r += line;
+  }
+  return r;
+}
+
+#endif
@@ -0,0 +1,181 @@
+#ifndef GF2_THREAD_POOL_H
+#define GF2_THREAD_POOL_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+A fixed set of worker threads running parallel loops with work stealing.
+Every worker starts on its own contiguous slice of the index range and takes indices from the front of it.
+A worker that runs dry steals the back half of the largest remaining slice, so uneven work
+(factoring cost varies wildly between polynomials) still keeps all workers busy.
+One loop runs at a time, parallel_for blocks until all indices are done and must not be called from inside a loop body.
+*/
+class gf2_thread_pool {
+  public:
+    // threads = 0 uses one worker per hardware thread
+    explicit gf2_thread_pool(unsigned threads = 0) {
+      if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+      for (unsigned w = 0; w < threads; ++w)
+        slices.emplace_back(new slice());
+      for (unsigned w = 0; w < threads; ++w)
+        workers.emplace_back(&gf2_thread_pool::worker_loop, this, w);
+    }
+
+    ~gf2_thread_pool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+      }
+      work_available.notify_all();
+      for (auto& t : workers)
+        t.join();
+    }
+
+    gf2_thread_pool(const gf2_thread_pool&) = delete;
+    gf2_thread_pool& operator = (const gf2_thread_pool&) = delete;
+
+    unsigned size() const {
+      return (unsigned)workers.size();
+    }
+
+    /*
+    Calls fun(i, worker) for every i in [0, n), where worker in [0, size()) identifies the calling thread.
+    The first exception thrown by fun cancels the remaining indices and is rethrown here.
+    */
+    void parallel_for(size_t n, const std::function<void(size_t, unsigned)>& fun) {
+      if (n == 0)
+        return;
+      std::lock_guard<std::mutex> loop_lock(loop_mutex);
+      std::unique_lock<std::mutex> lock(mutex);
+      const size_t count = slices.size();
+      for (size_t w = 0; w < count; ++w) {
+        std::lock_guard<std::mutex> slice_lock(slices[w]->mutex);
+        slices[w]->begin = n*w/count;
+        slices[w]->end = n*(w+1)/count;
+      }
+      job = &fun;
+      error = nullptr;
+      busy = (unsigned)count;
+      ++generation;
+      work_available.notify_all();
+      work_done.wait(lock, [this] { return busy == 0; });
+      job = nullptr;
+      if (error)
+        std::rethrow_exception(error);
+    }
+
+  private:
+    struct slice {
+      std::mutex mutex;
+      size_t begin = 0;
+      size_t end = 0;
+    };
+
+    bool take(unsigned w, size_t& index) {
+      slice& own = *slices[w];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (own.begin == own.end)
+        return false;
+      index = own.begin++;
+      return true;
+    }
+
+    // moves the back half of the largest other slice to worker w
+    bool steal(unsigned w) {
+      while (true) {
+        size_t victim = slices.size();
+        size_t largest = 0;
+        for (size_t v = 0; v < slices.size(); ++v) {
+          if (v == w)
+            continue;
+          std::lock_guard<std::mutex> lock(slices[v]->mutex);
+          if (slices[v]->end - slices[v]->begin > largest) {
+            largest = slices[v]->end - slices[v]->begin;
+            victim = v;
+          }
+        }
+        if (victim == slices.size())
+          return false;
+        slice& from = *slices[victim];
+        slice& to = *slices[w];
+        std::lock(from.mutex, to.mutex);
+        std::lock_guard<std::mutex> lock_from(from.mutex, std::adopt_lock);
+        std::lock_guard<std::mutex> lock_to(to.mutex, std::adopt_lock);
+        // the victim may have progressed in the meantime
+        if (from.begin == from.end)
+          continue;
+        const size_t mid = from.begin + (from.end - from.begin)/2;
+        to.begin = mid;
+        to.end = from.end;
+        from.end = mid;
+        return true;
+      }
+    }
+
+    void cancel() {
+      for (auto& s : slices) {
+        std::lock_guard<std::mutex> lock(s->mutex);
+        s->begin = s->end;
+      }
+    }
+
+    void worker_loop(unsigned w) {
+      uint64_t seen = 0;
+      while (true) {
+        const std::function<void(size_t, unsigned)>* fun;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          work_available.wait(lock, [&] { return stop || generation != seen; });
+          if (stop)
+            return;
+          seen = generation;
+          fun = job;
+        }
+        size_t index;
+        while (true) {
+          if (!take(w, index)) {
+            if (!steal(w))
+              break;
+            continue;
+          }
+          try {
+            (*fun)(index, w);
+          }
+          catch (...) {
+            {
+              std::lock_guard<std::mutex> lock(mutex);
+              if (!error)
+                error = std::current_exception();
+            }
+            cancel();
+          }
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--busy == 0)
+          work_done.notify_all();
+      }
+    }
+
+    std::vector<std::unique_ptr<slice>> slices;
+    std::vector<std::thread> workers;
+    std::mutex loop_mutex;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    const std::function<void(size_t, unsigned)>* job = nullptr;
+    std::exception_ptr error;
+    uint64_t generation = 0;
+    unsigned busy = 0;
+    bool stop = false;
+};
+
+#endif